@@ -0,0 +1,637 @@
+//
+//  LadderBench.cpp
+//
+//  Microbenchmarks for the ladder filters. Built and run by the bench target
+//  in Builds/LinuxMakefile/Makefile; needs nothing from JUCE so the same
+//  numbers can be taken on any build host.
+//
+//  usage: LadderBench [--samples N] [--warmup N] [--reps N] [--only text]
+//
+//  Prints one JSON document to stdout: "results" for the grid of models,
+//  block sizes, side chains, pole counts and solvers, "decayTail" for the
+//  silence after the input stops, with and without each kind of denormal
+//  protection.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include <sys/utsname.h>
+#include "../joeyMoogClasses/LinearJoeyMoogSC.hpp"
+#include "../joeyMoogClasses/NonLinearJoeyMoogSC.hpp"
+
+namespace
+{
+    /** run settings, from the command line */
+    struct Settings
+    {
+        /** samples filtered in each timed repetition */
+        int numSamples = 48000;
+        /** untimed repetitions before the timed ones */
+        int numWarmup = 3;
+        /** timed repetitions, the statistics are taken over these */
+        int numReps = 21;
+        /** only run cases whose name contains this */
+        std::string only;
+    };
+
+    /** one point of the benchmark grid */
+    struct Case
+    {
+        const char* model;
+        const char* precision;
+        const char* api;
+        const char* sideChain;
+        LadderSaturation saturation;
+        int blockSize;
+        double resonance;
+        double cutoff;
+        /** MoogLadder::setControlInterval(), 1 reads the side chains every sample */
+        int controlInterval;
+        /** ladder stages, see Ladder */
+        int poles;
+        /** MoogLadder::setSolver() */
+        LadderSolver solver;
+    };
+
+    /** signals shared by every case so they all filter the same thing */
+    struct Signals
+    {
+        std::vector<float> input, output, resonance, cutoff;
+    };
+
+    /** ns/sample statistics over the timed repetitions */
+    struct Timing
+    {
+        double median = 0, p99 = 0, min = 0, mean = 0;
+    };
+
+    /** @returns the statistics of the timed repetitions, sorting them in place */
+    Timing summariseTiming(std::vector<double>& nsPerSample)
+    {
+        Timing timing;
+        std::sort(nsPerSample.begin(), nsPerSample.end());
+        const size_t count = nsPerSample.size();
+        // nearest rank percentiles
+        timing.median = nsPerSample[(count - 1)/2];
+        timing.p99 = nsPerSample[std::min(count - 1, (size_t) ceil(0.99*count) - 1)];
+        timing.min = nsPerSample.front();
+        for (double value : nsPerSample)
+            timing.mean += value/count;
+        return timing;
+    }
+
+    /** what one case measured */
+    struct Result
+    {
+        Timing nsPerSample;
+        /** sum of the output, printed so the filtering cannot be optimised out */
+        double checksum = 0;
+        /** RMS difference from the same case read every sample, over the RMS of
+            that; NaN when the case reads every sample */
+        double controlRateError = std::numeric_limits<double>::quiet_NaN();
+    };
+
+    const char* saturationName(LadderSaturation saturation)
+    {
+        switch (saturation)
+        {
+            case LadderSaturation::exact:    return "exact";
+            case LadderSaturation::rational: return "rational";
+            case LadderSaturation::table:    return "table";
+        }
+        return "unknown";
+    }
+
+    const char* solverName(LadderSolver solver)
+    {
+        switch (solver)
+        {
+            case LadderSolver::linearised:       return "linearised";
+            case LadderSolver::implicitDraft:    return "implicitDraft";
+            case LadderSolver::implicitStandard: return "implicitStandard";
+            case LadderSolver::implicitPrecise:  return "implicitPrecise";
+        }
+        return "unknown";
+    }
+
+    /** the linear model has no saturation to choose */
+    const char* saturationName(const Case& c)
+    {
+        return strcmp(c.model, "linear") == 0 ? "none" : saturationName(c.saturation);
+    }
+
+    bool isModulated(const Case& c)
+    {
+        return strcmp(c.sideChain, "modulated") == 0;
+    }
+
+    std::string caseName(const Case& c)
+    {
+        char name[160];
+        const int length = snprintf(name, sizeof(name), "%s/%s/%s/%s/%s/b%d",
+                                    c.model, saturationName(c), c.precision, c.api,
+                                    c.sideChain, c.blockSize);
+        int suffix = length;
+        if (! isModulated(c))
+            suffix += snprintf(name + suffix, sizeof(name) - suffix, "/r%.2f/c%.2f", c.resonance, c.cutoff);
+        else if (c.controlInterval > 1)
+            suffix += snprintf(name + suffix, sizeof(name) - suffix, "/k%d", c.controlInterval);
+
+        // the four pole linearised ladder is the default and keeps its names
+        if (c.poles != 4)
+            suffix += snprintf(name + suffix, sizeof(name) - suffix, "/p%d", c.poles);
+        if (c.solver != LadderSolver::linearised)
+            snprintf(name + suffix, sizeof(name) - suffix, "/%s", solverName(c.solver));
+        return name;
+    }
+
+    /** a JSON number, or null for values that are not one */
+    std::string jsonNumber(double value, const char* format)
+    {
+        if (! std::isfinite(value))
+            return "null";
+
+        char text[32];
+        snprintf(text, sizeof(text), format, value);
+        return text;
+    }
+
+    //==========================================================================
+    /** fills the input with white noise and the side chains with slow sweeps.
+        Resonance stays at or below 0.8: higher, the linear model blows up at
+        high cutoffs and would be timed running on infs and NaNs */
+    void makeSignals(Signals& signals, int numSamples)
+    {
+        signals.input.resize(numSamples);
+        signals.output.resize(numSamples);
+        signals.resonance.resize(numSamples);
+        signals.cutoff.resize(numSamples);
+
+        unsigned int seed = 1;
+        for (int n = 0; n < numSamples; n++)
+        {
+            seed = seed*1664525u + 1013904223u;
+            signals.input[n] = ((seed >> 8)*(1.0f/16777216.0f) - 0.5f);
+
+            const double phase = (double) n/numSamples;
+            signals.resonance[n] = (float) (0.4 + 0.35*sin(2*3.1415926536*3*phase));
+            signals.cutoff[n] = (float) (0.05 + 0.9*fabs(2*(4*phase - floor(4*phase)) - 1));
+        }
+    }
+
+    /** runs filter through the signals once, the way the case asks */
+    template <class Filter, typename Sample>
+    void runOnce(Filter& filter, const Case& c, Signals& signals)
+    {
+        const int numSamples = (int) signals.input.size();
+        const bool modulated = isModulated(c);
+        const float* in = signals.input.data();
+        float* out = signals.output.data();
+
+        if (strcmp(c.api, "filter") == 0)
+        {
+            for (int n = 0; n < numSamples; n++)
+            {
+                const Sample resonance = modulated ? (Sample) signals.resonance[n] : (Sample) c.resonance;
+                const Sample cutoff = modulated ? (Sample) signals.cutoff[n] : (Sample) c.cutoff;
+                out[n] = (float) filter.filter((Sample) in[n], resonance, cutoff);
+            }
+            return;
+        }
+
+        for (int start = 0; start < numSamples; start += c.blockSize)
+        {
+            const int blockSize = std::min(c.blockSize, numSamples - start);
+            if (modulated)
+                filter.processBlock(in + start, out + start, blockSize,
+                                    signals.resonance.data() + start, signals.cutoff.data() + start);
+            else
+                filter.processBlock(in + start, out + start, blockSize, c.resonance, c.cutoff);
+        }
+    }
+
+    /** @returns the RMS difference between the case and the same case reading
+        its side chains every sample, relative to the RMS of the latter */
+    template <class Filter, typename Sample>
+    double measureControlRateError(const Case& c, Signals& signals)
+    {
+        Filter everySample(48000), decimated(48000);
+        everySample.setSaturation(c.saturation);
+        decimated.setSaturation(c.saturation);
+        everySample.setSolver(c.solver);
+        decimated.setSolver(c.solver);
+        decimated.setControlInterval(c.controlInterval);
+
+        runOnce<Filter, Sample>(everySample, c, signals);
+        const std::vector<float> reference = signals.output;
+        runOnce<Filter, Sample>(decimated, c, signals);
+
+        double error = 0, power = 0;
+        for (size_t n = 0; n < reference.size(); n++)
+        {
+            const double difference = signals.output[n] - (double) reference[n];
+            error += difference*difference;
+            power += reference[n]*(double) reference[n];
+        }
+        return sqrt(error/power);
+    }
+
+    /** times one case: warmup, then numReps timed runs on the same filter */
+    template <class Filter, typename Sample>
+    Result runCase(const Case& c, Signals& signals, const Settings& settings)
+    {
+        Filter filter(48000);
+        filter.setSaturation(c.saturation);
+        filter.setSolver(c.solver);
+        filter.setControlInterval(c.controlInterval);
+
+        for (int i = 0; i < settings.numWarmup; i++)
+            runOnce<Filter, Sample>(filter, c, signals);
+
+        std::vector<double> nsPerSample(settings.numReps);
+        for (int i = 0; i < settings.numReps; i++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            runOnce<Filter, Sample>(filter, c, signals);
+            const auto end = std::chrono::steady_clock::now();
+            nsPerSample[i] = std::chrono::duration<double, std::nano>(end - start).count()/signals.input.size();
+        }
+
+        Result result;
+        result.nsPerSample = summariseTiming(nsPerSample);
+        for (float value : signals.output)
+            result.checksum += value;
+
+        if (c.controlInterval > 1)
+            result.controlRateError = measureControlRateError<Filter, Sample>(c, signals);
+        return result;
+    }
+
+    /** picks the filter type for a case with the given pole count */
+    template <int Poles>
+    Result runCase(const Case& c, Signals& signals, const Settings& settings)
+    {
+        const bool linear = strcmp(c.model, "linear") == 0;
+        const bool isDouble = strcmp(c.precision, "double") == 0;
+
+        if (linear)
+            return isDouble ? runCase<Ladder<Poles, double, LinearLadder>, double>(c, signals, settings)
+                            : runCase<Ladder<Poles, float, LinearLadder>, float>(c, signals, settings);
+
+        return isDouble ? runCase<Ladder<Poles, double, NonLinearLadder>, double>(c, signals, settings)
+                        : runCase<Ladder<Poles, float, NonLinearLadder>, float>(c, signals, settings);
+    }
+
+    /** picks the pole count for a case */
+    Result runCase(const Case& c, Signals& signals, const Settings& settings)
+    {
+        switch (c.poles)
+        {
+            case 2:  return runCase<2>(c, signals, settings);
+            case 6:  return runCase<6>(c, signals, settings);
+            case 8:  return runCase<8>(c, signals, settings);
+            default: return runCase<4>(c, signals, settings);
+        }
+    }
+
+    //==========================================================================
+    /** the denormal protection a decay tail case runs with */
+    enum class Protection
+    {
+        none,       /**< neither: the state sinks into subnormals */
+        flushState, /**< MoogLadder::setStateFlushing() */
+        flushFPU    /**< ScopedFlushDenormals around the processing */
+    };
+
+    /** one decay tail case: the input stops and the filter rings down */
+    struct TailCase
+    {
+        const char* model;
+        const char* precision;
+        Protection protection;
+    };
+
+    const char* protectionName(Protection protection)
+    {
+        switch (protection)
+        {
+            case Protection::none:       return "none";
+            case Protection::flushState: return "flushState";
+            case Protection::flushFPU:   return "flushFPU";
+        }
+        return "unknown";
+    }
+
+    std::string tailCaseName(const TailCase& c)
+    {
+        return std::string("tail/") + c.model + "/" + c.precision + "/" + protectionName(c.protection);
+    }
+
+    /** decay tails run a static side chain with a long ring, in blocks of this */
+    const int tailBlockSize = 256;
+    const double tailResonance = 0.8, tailCutoff = 0.2;
+
+    /** ns/sample over the part of a decay tail where it turns subnormal */
+    struct TailResult
+    {
+        /** samples of silence before the timed window */
+        long tailStart = 0;
+        int tailLength = 0;
+        Timing nsPerSample;
+        double checksum = 0;
+    };
+
+    /** filters numSamples of silence in tail blocks, with the protection asked for */
+    template <class Filter>
+    void runSilence(Filter& filter, Protection protection, const std::vector<float>& silence, long numSamples)
+    {
+        float out[tailBlockSize];
+
+        if (protection == Protection::flushFPU)
+        {
+            const ScopedFlushDenormals flushDenormals;
+            for (long done = 0; done < numSamples; done += tailBlockSize)
+                filter.processBlock(silence.data(), out, (int) std::min((long) tailBlockSize, numSamples - done),
+                                    tailResonance, tailCutoff);
+        }
+        else
+        {
+            for (long done = 0; done < numSamples; done += tailBlockSize)
+                filter.processBlock(silence.data(), out, (int) std::min((long) tailBlockSize, numSamples - done),
+                                    tailResonance, tailCutoff);
+        }
+    }
+
+    /**
+     times a decay tail: a second of noise, then silence. The timed window is
+     the silence from where an unprotected filter's output falls under the
+     smallest normal Sample times 2^20, so it covers the stretch where the
+     unprotected state goes subnormal; every protection is timed over the
+     same stretch of the tail.
+     */
+    template <class Filter, typename Sample>
+    TailResult runTailCase(const TailCase& c, Signals& signals, const Settings& settings)
+    {
+        const std::vector<float> silence(tailBlockSize, 0.0f);
+        const int burstLength = std::min((int) signals.input.size(), 48000);
+        const double subnormalSoon = std::numeric_limits<Sample>::min()*1048576.0;
+        const long maxTail = 48000L*600;
+
+        // find where the unprotected tail gets there
+        TailResult result;
+        {
+            Filter probe(48000);
+            probe.setSaturation(LadderSaturation::rational);
+            probe.setStateFlushing(false);
+            probe.processBlock(signals.input.data(), signals.output.data(), burstLength, tailResonance, tailCutoff);
+
+            // filter() returns the output as Sample: the float processBlock()
+            // output underflows long before a double state does. The peak is
+            // over a block so a zero crossing of the ring does not end it early
+            double peak = 1;
+            for (; result.tailStart < maxTail && peak >= subnormalSoon; result.tailStart += tailBlockSize)
+            {
+                peak = 0;
+                for (int n = 0; n < tailBlockSize; n++)
+                    peak = std::max(peak, (double) std::abs(probe.filter(0, (Sample) tailResonance, (Sample) tailCutoff)));
+            }
+        }
+
+        Filter ready(48000);
+        ready.setSaturation(LadderSaturation::rational);
+        ready.setStateFlushing(c.protection == Protection::flushState);
+        ready.processBlock(signals.input.data(), signals.output.data(), burstLength, tailResonance, tailCutoff);
+        runSilence(ready, c.protection, silence, result.tailStart);
+
+        result.tailLength = settings.numSamples;
+        for (int i = 0; i < settings.numWarmup; i++)
+        {
+            Filter filter(ready);
+            runSilence(filter, c.protection, silence, result.tailLength);
+        }
+
+        std::vector<double> nsPerSample(settings.numReps);
+        for (int i = 0; i < settings.numReps; i++)
+        {
+            Filter filter(ready);
+            const auto start = std::chrono::steady_clock::now();
+            runSilence(filter, c.protection, silence, result.tailLength);
+            const auto end = std::chrono::steady_clock::now();
+            nsPerSample[i] = std::chrono::duration<double, std::nano>(end - start).count()/result.tailLength;
+            result.checksum += filter.filter(0, (Sample) tailResonance, (Sample) tailCutoff);
+        }
+
+        result.nsPerSample = summariseTiming(nsPerSample);
+        return result;
+    }
+
+    /** picks the filter type for a decay tail case */
+    TailResult runTailCase(const TailCase& c, Signals& signals, const Settings& settings)
+    {
+        const bool linear = strcmp(c.model, "linear") == 0;
+        const bool isDouble = strcmp(c.precision, "double") == 0;
+
+        if (linear)
+            return isDouble ? runTailCase<MoogLadder<double, LinearLadder>, double>(c, signals, settings)
+                            : runTailCase<MoogLadder<float, LinearLadder>, float>(c, signals, settings);
+
+        return isDouble ? runTailCase<MoogLadder<double, NonLinearLadder>, double>(c, signals, settings)
+                        : runTailCase<MoogLadder<float, NonLinearLadder>, float>(c, signals, settings);
+    }
+
+    /** every model and precision with each protection */
+    std::vector<TailCase> makeTailCases()
+    {
+        const char* models[] = { "linear", "nonlinear" };
+        const char* precisions[] = { "double", "float" };
+        const Protection protections[] = { Protection::none, Protection::flushState, Protection::flushFPU };
+
+        std::vector<TailCase> cases;
+        for (const char* model : models)
+            for (const char* precision : precisions)
+                for (Protection protection : protections)
+                    cases.push_back({ model, precision, protection });
+        return cases;
+    }
+
+    //==========================================================================
+    /** the grid: every model and precision with a modulated side chain over
+        the block sizes, the control intervals, the other pole counts and, for
+        the nonlinear models, the implicit solvers, and a static side chain
+        over a cutoff/resonance sweep */
+    std::vector<Case> makeCases()
+    {
+        struct Model { const char* name; LadderSaturation saturation; };
+        const Model models[] = {
+            { "linear",    LadderSaturation::exact },
+            { "nonlinear", LadderSaturation::exact },
+            { "nonlinear", LadderSaturation::rational },
+            { "nonlinear", LadderSaturation::table }
+        };
+        const char* precisions[] = { "double", "float" };
+        const int blockSizes[] = { 16, 64, 256, 1024 };
+        const int controlIntervals[] = { 16, 32, 64 };
+        const int otherPoles[] = { 2, 6, 8 };
+        const LadderSolver implicitSolvers[] = { LadderSolver::implicitDraft, LadderSolver::implicitStandard,
+                                                 LadderSolver::implicitPrecise };
+        const double resonances[] = { 0.1, 0.5, 0.8 };
+        const double cutoffs[] = { 0.2, 0.5, 0.7 };
+
+        std::vector<Case> cases;
+        for (const Model& model : models)
+        {
+            for (const char* precision : precisions)
+            {
+                cases.push_back({ model.name, precision, "filter", "static", model.saturation, 1, 0.5, 0.5, 1, 4,
+                                  LadderSolver::linearised });
+                cases.push_back({ model.name, precision, "filter", "modulated", model.saturation, 1, 0, 0, 1, 4,
+                                  LadderSolver::linearised });
+
+                for (int blockSize : blockSizes)
+                    cases.push_back({ model.name, precision, "processBlock", "modulated",
+                                      model.saturation, blockSize, 0, 0, 1, 4, LadderSolver::linearised });
+
+                for (int controlInterval : controlIntervals)
+                    cases.push_back({ model.name, precision, "processBlock", "modulated",
+                                      model.saturation, 256, 0, 0, controlInterval, 4, LadderSolver::linearised });
+
+                // the four pole case is b256 above
+                for (int poles : otherPoles)
+                    cases.push_back({ model.name, precision, "processBlock", "modulated",
+                                      model.saturation, 256, 0, 0, 1, poles, LadderSolver::linearised });
+
+                if (strcmp(model.name, "nonlinear") == 0)
+                    for (LadderSolver solver : implicitSolvers)
+                        cases.push_back({ model.name, precision, "processBlock", "modulated",
+                                          model.saturation, 256, 0, 0, 1, 4, solver });
+
+                for (double resonance : resonances)
+                    for (double cutoff : cutoffs)
+                        cases.push_back({ model.name, precision, "processBlock", "static",
+                                          model.saturation, 256, resonance, cutoff, 1, 4,
+                                          LadderSolver::linearised });
+            }
+        }
+        return cases;
+    }
+
+    /** compiler and machine the numbers came from */
+    void printHost(const Settings& settings)
+    {
+        utsname host;
+        const bool haveHost = uname(&host) == 0;
+
+        printf("{\n");
+        printf("  \"host\": {\n");
+        printf("    \"machine\": \"%s\",\n", haveHost ? host.machine : "unknown");
+        printf("    \"kernel\": \"%s\",\n", haveHost ? host.release : "unknown");
+#if defined(__clang__)
+        printf("    \"compiler\": \"clang %d.%d.%d\",\n", __clang_major__, __clang_minor__, __clang_patchlevel__);
+#elif defined(__GNUC__)
+        printf("    \"compiler\": \"gcc %d.%d.%d\",\n", __GNUC__, __GNUC_MINOR__, __GNUC_PATCHLEVEL__);
+#else
+        printf("    \"compiler\": \"unknown\",\n");
+#endif
+        printf("    \"saturationDefault\": \"%s\",\n", saturationName(LadderSaturation::JOEY_MOOG_SATURATION));
+        printf("    \"solverDefault\": \"%s\"\n", solverName(LadderSolver::JOEY_MOOG_SOLVER));
+        printf("  },\n");
+        printf("  \"settings\": { \"sampleRate\": 48000, \"samples\": %d, \"warmup\": %d, \"reps\": %d },\n",
+               settings.numSamples, settings.numWarmup, settings.numReps);
+    }
+
+    bool parseSettings(int argc, char* argv[], Settings& settings)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string flag = argv[i];
+            if (i + 1 >= argc)
+                return false;
+
+            if (flag == "--samples")     settings.numSamples = atoi(argv[++i]);
+            else if (flag == "--warmup") settings.numWarmup = atoi(argv[++i]);
+            else if (flag == "--reps")   settings.numReps = atoi(argv[++i]);
+            else if (flag == "--only")   settings.only = argv[++i];
+            else return false;
+        }
+        return settings.numSamples > 0 && settings.numWarmup >= 0 && settings.numReps > 0;
+    }
+}
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    Settings settings;
+    if (! parseSettings(argc, argv, settings))
+    {
+        fprintf(stderr, "usage: LadderBench [--samples N] [--warmup N] [--reps N] [--only text]\n");
+        return 1;
+    }
+
+    Signals signals;
+    makeSignals(signals, settings.numSamples);
+
+    printHost(settings);
+    printf("  \"results\": [");
+
+    bool first = true;
+    for (const Case& c : makeCases())
+    {
+        const std::string name = caseName(c);
+        if (name.find(settings.only) == std::string::npos)
+            continue;
+
+        const Result result = runCase(c, signals, settings);
+        // resonance and cutoff are null when they follow the sweeps
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        printf("%s\n    { \"name\": \"%s\", \"model\": \"%s\", \"saturation\": \"%s\", \"precision\": \"%s\", "
+               "\"api\": \"%s\", \"sideChain\": \"%s\", \"blockSize\": %d, \"controlInterval\": %d, \"poles\": %d, "
+               "\"solver\": \"%s\", "
+               "\"resonance\": %s, \"cutoff\": %s, "
+               "\"nsPerSample\": { \"median\": %.3f, \"p99\": %.3f, \"min\": %.3f, \"mean\": %.3f }, "
+               "\"samplesPerSecond\": %.0f, \"controlRateError\": %s, \"checksum\": %s }",
+               first ? "" : ",", name.c_str(), c.model, saturationName(c), c.precision,
+               c.api, c.sideChain, c.blockSize, c.controlInterval, c.poles,
+               solverName(c.solver),
+               jsonNumber(isModulated(c) ? nan : c.resonance, "%.2f").c_str(),
+               jsonNumber(isModulated(c) ? nan : c.cutoff, "%.2f").c_str(),
+               result.nsPerSample.median, result.nsPerSample.p99, result.nsPerSample.min, result.nsPerSample.mean,
+               1.0e9/result.nsPerSample.median, jsonNumber(result.controlRateError, "%.3g").c_str(),
+               jsonNumber(result.checksum, "%.6g").c_str());
+        fflush(stdout);
+        first = false;
+    }
+
+    printf("\n  ],\n");
+    printf("  \"decayTail\": [");
+
+    // the same stretch of silence after a burst of noise, with each protection
+    first = true;
+    for (const TailCase& c : makeTailCases())
+    {
+        const std::string name = tailCaseName(c);
+        if (name.find(settings.only) == std::string::npos)
+            continue;
+
+        const TailResult result = runTailCase(c, signals, settings);
+        printf("%s\n    { \"name\": \"%s\", \"model\": \"%s\", \"saturation\": \"%s\", \"precision\": \"%s\", "
+               "\"protection\": \"%s\", \"blockSize\": %d, \"resonance\": %.2f, \"cutoff\": %.2f, "
+               "\"tailStart\": %ld, \"tailLength\": %d, "
+               "\"nsPerSample\": { \"median\": %.3f, \"p99\": %.3f, \"min\": %.3f }, \"checksum\": %s }",
+               first ? "" : ",", name.c_str(), c.model, strcmp(c.model, "linear") == 0 ? "none" : "rational",
+               c.precision, protectionName(c.protection), tailBlockSize, tailResonance, tailCutoff,
+               result.tailStart, result.tailLength,
+               result.nsPerSample.median, result.nsPerSample.p99, result.nsPerSample.min,
+               jsonNumber(result.checksum, "%.6g").c_str());
+        fflush(stdout);
+        first = false;
+    }
+
+    printf("\n  ]\n}\n");
+    return 0;
+}
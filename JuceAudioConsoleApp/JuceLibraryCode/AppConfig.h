@@ -48,19 +48,39 @@
 #define JUCE_USE_DARK_SPLASH_SCREEN 1
 
 //==============================================================================
-#define JUCE_MODULE_AVAILABLE_juce_audio_basics          1
-#define JUCE_MODULE_AVAILABLE_juce_audio_devices         1
-#define JUCE_MODULE_AVAILABLE_juce_audio_formats         1
-#define JUCE_MODULE_AVAILABLE_juce_audio_processors      1
-#define JUCE_MODULE_AVAILABLE_juce_core                  1
-#define JUCE_MODULE_AVAILABLE_juce_cryptography          1
-#define JUCE_MODULE_AVAILABLE_juce_data_structures       1
-#define JUCE_MODULE_AVAILABLE_juce_events                1
-#define JUCE_MODULE_AVAILABLE_juce_graphics              1
-#define JUCE_MODULE_AVAILABLE_juce_gui_basics            1
-#define JUCE_MODULE_AVAILABLE_juce_gui_extra             1
-#define JUCE_MODULE_AVAILABLE_juce_opengl                1
-#define JUCE_MODULE_AVAILABLE_juce_video                 1
+#if JUCE_CONSOLE_HEADLESS
+ // make CONFIG=Headless: only the core, events and audio modules are built
+ #define JUCE_MODULE_AVAILABLE_juce_audio_basics          1
+ #define JUCE_MODULE_AVAILABLE_juce_audio_devices         1
+ #define JUCE_MODULE_AVAILABLE_juce_audio_formats         1
+ #define JUCE_MODULE_AVAILABLE_juce_audio_processors      0
+ #define JUCE_MODULE_AVAILABLE_juce_core                  1
+ #define JUCE_MODULE_AVAILABLE_juce_cryptography          0
+ #define JUCE_MODULE_AVAILABLE_juce_data_structures       0
+ #define JUCE_MODULE_AVAILABLE_juce_events                1
+ #define JUCE_MODULE_AVAILABLE_juce_graphics              0
+ #define JUCE_MODULE_AVAILABLE_juce_gui_basics            0
+ #define JUCE_MODULE_AVAILABLE_juce_gui_extra             0
+ #define JUCE_MODULE_AVAILABLE_juce_opengl                0
+ #define JUCE_MODULE_AVAILABLE_juce_video                 0
+
+ // nothing left to fetch URLs with, so no libcurl either
+ #define JUCE_USE_CURL 0
+#else
+ #define JUCE_MODULE_AVAILABLE_juce_audio_basics          1
+ #define JUCE_MODULE_AVAILABLE_juce_audio_devices         1
+ #define JUCE_MODULE_AVAILABLE_juce_audio_formats         1
+ #define JUCE_MODULE_AVAILABLE_juce_audio_processors      1
+ #define JUCE_MODULE_AVAILABLE_juce_core                  1
+ #define JUCE_MODULE_AVAILABLE_juce_cryptography          1
+ #define JUCE_MODULE_AVAILABLE_juce_data_structures       1
+ #define JUCE_MODULE_AVAILABLE_juce_events                1
+ #define JUCE_MODULE_AVAILABLE_juce_graphics              1
+ #define JUCE_MODULE_AVAILABLE_juce_gui_basics            1
+ #define JUCE_MODULE_AVAILABLE_juce_gui_extra             1
+ #define JUCE_MODULE_AVAILABLE_juce_opengl                1
+ #define JUCE_MODULE_AVAILABLE_juce_video                 1
+#endif
 
 #define JUCE_GLOBAL_MODULE_SETTINGS_INCLUDED 1
 
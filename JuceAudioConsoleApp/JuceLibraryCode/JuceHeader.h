@@ -17,16 +17,22 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_audio_devices/juce_audio_devices.h>
 #include <juce_audio_formats/juce_audio_formats.h>
+#if ! JUCE_CONSOLE_HEADLESS
 #include <juce_audio_processors/juce_audio_processors.h>
+#endif
 #include <juce_core/juce_core.h>
+#if ! JUCE_CONSOLE_HEADLESS
 #include <juce_cryptography/juce_cryptography.h>
 #include <juce_data_structures/juce_data_structures.h>
+#endif
 #include <juce_events/juce_events.h>
+#if ! JUCE_CONSOLE_HEADLESS
 #include <juce_graphics/juce_graphics.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_gui_extra/juce_gui_extra.h>
 #include <juce_opengl/juce_opengl.h>
 #include <juce_video/juce_video.h>
+#endif
 
 
 #if ! DONT_SET_USING_JUCE_NAMESPACE
@@ -0,0 +1,479 @@
+//
+//  AlsaMmapDevice.cpp
+//
+
+#include "AlsaMmapDevice.hpp"
+
+#if JUCE_LINUX
+
+#include <cerrno>
+
+namespace
+{
+    /** sample formats to try, best first. Native endian, as the mapped area is written directly */
+    const snd_pcm_format_t formats[] =
+    {
+        SND_PCM_FORMAT_FLOAT, SND_PCM_FORMAT_S32, SND_PCM_FORMAT_S24, SND_PCM_FORMAT_S16
+    };
+
+    /** @returns a message with ALSA's description of error */
+    String describe(const String& message, int error)
+    {
+        return message + ": " + snd_strerror(error);
+    }
+
+    /** @returns sample scaled to an integer of the given full scale */
+    inline int32 toInteger(float sample, double fullScale)
+    {
+        return (int32) std::lrint(jlimit(-1.0f, 1.0f, sample) * fullScale);
+    }
+}
+//==============================================================================
+AlsaMmapDevice::AlsaMmapDevice(const String& name, const String& deviceTypeName,
+                               double rate, int period, int periods)
+    : AudioIODevice(name, deviceTypeName), Thread("ALSA mmap " + name),
+      pcmName(name), requestedSampleRate(rate),
+      requestedPeriodSize(jmax(1, period)), requestedNumPeriods(jmax(2, periods))
+{
+}
+
+AlsaMmapDevice::~AlsaMmapDevice()
+{
+    close();
+}
+//==============================================================================
+StringArray AlsaMmapDevice::getOutputChannelNames()
+{
+    StringArray names;
+    for (int i = 0; i < jmax(2, numChannels); ++i)
+        names.add("Output " + String(i + 1));
+    return names;
+}
+
+StringArray AlsaMmapDevice::getInputChannelNames()
+{
+    return StringArray();
+}
+
+Array<double> AlsaMmapDevice::getAvailableSampleRates()
+{
+    Array<double> rates;
+    rates.add(requestedSampleRate);
+    return rates;
+}
+
+Array<int> AlsaMmapDevice::getAvailableBufferSizes()
+{
+    Array<int> sizes;
+    sizes.add(requestedPeriodSize);
+    return sizes;
+}
+
+int AlsaMmapDevice::getDefaultBufferSize()
+{
+    return requestedPeriodSize;
+}
+//==============================================================================
+String AlsaMmapDevice::open(const BigInteger&, const BigInteger& outputChannels,
+                            double newSampleRate, int bufferSizeSamples)
+{
+    close();
+    lastError.clear();
+
+    int error = snd_pcm_open(&pcm, pcmName.toRawUTF8(), SND_PCM_STREAM_PLAYBACK, 0);
+    if (error < 0)
+    {
+        pcm = nullptr;
+        return fail("could not open " + pcmName, error);
+    }
+
+    //==========================================================================
+    snd_pcm_hw_params_t* hw;
+    snd_pcm_hw_params_alloca(&hw);
+    snd_pcm_hw_params_any(pcm, hw);
+
+    // a resampler would reblock the audio and add its own delay
+    snd_pcm_hw_params_set_rate_resample(pcm, hw, 0);
+
+    if ((error = snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0)
+        return fail(pcmName + " does not support interleaved mmap access", error);
+
+    format = SND_PCM_FORMAT_UNKNOWN;
+    for (snd_pcm_format_t candidate : formats)
+    {
+        if (snd_pcm_hw_params_test_format(pcm, hw, candidate) == 0)
+        {
+            format = candidate;
+            break;
+        }
+    }
+
+    if (format == SND_PCM_FORMAT_UNKNOWN || (error = snd_pcm_hw_params_set_format(pcm, hw, format)) < 0)
+        return fail(pcmName + " has no float, 32, 24 or 16 bit format", error < 0 ? error : -EINVAL);
+
+    unsigned int channels = (unsigned int) jmax(1, outputChannels.getHighestBit() + 1);
+    if ((error = snd_pcm_hw_params_set_channels_near(pcm, hw, &channels)) < 0)
+        return fail("could not set the channels", error);
+
+    const unsigned int rate = (unsigned int) roundToInt(newSampleRate > 0 ? newSampleRate : requestedSampleRate);
+    if ((error = snd_pcm_hw_params_set_rate(pcm, hw, rate, 0)) < 0)
+        return fail(pcmName + " can't run at " + String(rate) + " Hz", error);
+
+    snd_pcm_uframes_t period = (snd_pcm_uframes_t) (bufferSizeSamples > 0 ? bufferSizeSamples : requestedPeriodSize);
+    int direction = 0;
+    if ((error = snd_pcm_hw_params_set_period_size_near(pcm, hw, &period, &direction)) < 0)
+        return fail("could not set the period size", error);
+
+    // some drivers only take a buffer size, and pick the period count from it
+    unsigned int periods = (unsigned int) requestedNumPeriods;
+    direction = 0;
+    if (snd_pcm_hw_params_set_periods_near(pcm, hw, &periods, &direction) < 0)
+    {
+        snd_pcm_uframes_t buffer = period * (snd_pcm_uframes_t) requestedNumPeriods;
+        if ((error = snd_pcm_hw_params_set_buffer_size_near(pcm, hw, &buffer)) < 0)
+            return fail("could not set the buffer size", error);
+    }
+
+    if ((error = snd_pcm_hw_params(pcm, hw)) < 0)
+        return fail("the driver refused the configuration", error);
+
+    // read back what the driver agreed to, which may differ from what was asked
+    snd_pcm_uframes_t agreedPeriod = 0, agreedBuffer = 0;
+    unsigned int agreedRate = 0, agreedChannels = 0;
+    snd_pcm_hw_params_get_period_size(hw, &agreedPeriod, &direction);
+    snd_pcm_hw_params_get_buffer_size(hw, &agreedBuffer);
+    snd_pcm_hw_params_get_rate(hw, &agreedRate, &direction);
+    snd_pcm_hw_params_get_channels(hw, &agreedChannels);
+
+    periodSize = (int) agreedPeriod;
+    bufferSize = (int) agreedBuffer;
+    numPeriods = periodSize > 0 ? bufferSize / periodSize : 0;
+    sampleRate = agreedRate;
+    numChannels = (int) agreedChannels;
+
+    //==========================================================================
+    // wake for every free period, and start only when run() has filled the
+    // ring buffer and says so
+    snd_pcm_sw_params_t* sw;
+    snd_pcm_sw_params_alloca(&sw);
+    snd_pcm_sw_params_current(pcm, sw);
+
+    snd_pcm_uframes_t boundary = 0;
+    snd_pcm_sw_params_get_boundary(sw, &boundary);
+    snd_pcm_sw_params_set_start_threshold(pcm, sw, boundary);
+    snd_pcm_sw_params_set_avail_min(pcm, sw, agreedPeriod);
+
+    if ((error = snd_pcm_sw_params(pcm, sw)) < 0)
+        return fail("could not set the software parameters", error);
+
+    if ((error = snd_pcm_prepare(pcm)) < 0)
+        return fail("could not prepare " + pcmName, error);
+
+    renderBuffer.setSize(numChannels, periodSize);
+    numXRuns = 0;
+    lowestFill = bufferSize;
+
+    // the same priority JUCE's own ALSA thread asks for
+    startThread(9);
+    return String();
+}
+
+void AlsaMmapDevice::close()
+{
+    stop();
+    stopThread(2000);
+
+    if (pcm != nullptr)
+    {
+        snd_pcm_close(pcm);
+        pcm = nullptr;
+    }
+}
+
+bool AlsaMmapDevice::isOpen()
+{
+    return pcm != nullptr;
+}
+//==============================================================================
+void AlsaMmapDevice::start(AudioIODeviceCallback* newCallback)
+{
+    if (newCallback != nullptr)
+        newCallback->audioDeviceAboutToStart(this);
+
+    const ScopedLock sl(callbackLock);
+    callback = newCallback;
+}
+
+void AlsaMmapDevice::stop()
+{
+    AudioIODeviceCallback* oldCallback;
+
+    {
+        const ScopedLock sl(callbackLock);
+        oldCallback = callback;
+        callback = nullptr;
+    }
+
+    if (oldCallback != nullptr)
+        oldCallback->audioDeviceStopped();
+}
+
+bool AlsaMmapDevice::isPlaying()
+{
+    return isThreadRunning() && callback != nullptr;
+}
+
+String AlsaMmapDevice::getLastError()
+{
+    return lastError;
+}
+//==============================================================================
+int AlsaMmapDevice::getCurrentBufferSizeSamples() { return periodSize; }
+double AlsaMmapDevice::getCurrentSampleRate() { return sampleRate; }
+int AlsaMmapDevice::getCurrentBitDepth() { return format == SND_PCM_FORMAT_UNKNOWN ? 0 : snd_pcm_format_width(format); }
+
+BigInteger AlsaMmapDevice::getActiveOutputChannels() const
+{
+    BigInteger channels;
+    channels.setRange(0, numChannels, true);
+    return channels;
+}
+
+BigInteger AlsaMmapDevice::getActiveInputChannels() const { return BigInteger(); }
+int AlsaMmapDevice::getOutputLatencyInSamples() { return bufferSize - periodSize; }
+int AlsaMmapDevice::getInputLatencyInSamples() { return 0; }
+int AlsaMmapDevice::getXRunCount() const noexcept { return numXRuns.load(); }
+//==============================================================================
+String AlsaMmapDevice::getLatencyReport() const
+{
+    if (pcm == nullptr)
+        return pcmName + " not open" + (lastError.isNotEmpty() ? ": " + lastError : String()) + "\n";
+
+    const double msPerFrame = 1000.0 / sampleRate;
+    String report;
+    report << pcmName << " (ALSA mmap): " << String(sampleRate, 0) << " Hz, " << numChannels
+           << " channels of " << snd_pcm_format_name(format) << "\n"
+           << "period " << periodSize << " frames (" << String(periodSize * msPerFrame, 2) << " ms) x "
+           << numPeriods << ", ring buffer " << bufferSize << " frames, so "
+           << String((bufferSize - periodSize) * msPerFrame, 2) << " to " << String(bufferSize * msPerFrame, 2)
+           << " ms from callback to output";
+
+    if (periodSize != requestedPeriodSize || numPeriods != requestedNumPeriods)
+        report << ", asked for " << requestedPeriodSize << " x " << requestedNumPeriods;
+
+    report << "\nlowest fill " << lowestFill.load() << " frames, " << numXRuns.load() << " xruns\n";
+    return report;
+}
+//==============================================================================
+void AlsaMmapDevice::run()
+{
+    // a full ring buffer of silence, so the first callback has the whole
+    // buffer of headroom, then start
+    int error = writeAvailable(false);
+    if (error == 0)
+        error = snd_pcm_start(pcm);
+
+    if (error < 0 && ! recover(error))
+        return;
+
+    while (! threadShouldExit())
+    {
+        const snd_pcm_sframes_t available = snd_pcm_avail_update(pcm);
+
+        if (available < 0)
+        {
+            if (! recover((int) available))
+                return;
+            continue;
+        }
+
+        if (available < periodSize)
+        {
+            // avail_min is one period, so this wakes when one is free
+            error = snd_pcm_wait(pcm, 100);
+            if (error < 0 && ! recover(error))
+                return;
+            continue;
+        }
+
+        const int fill = bufferSize - (int) available;
+        if (fill < lowestFill.load(std::memory_order_relaxed))
+            lowestFill.store(fill, std::memory_order_relaxed);
+
+        error = writeAvailable(true);
+        if (error < 0 && ! recover(error))
+            return;
+    }
+
+    snd_pcm_drop(pcm);
+}
+
+int AlsaMmapDevice::writeAvailable(bool useCallback)
+{
+    for (;;)
+    {
+        const snd_pcm_sframes_t available = snd_pcm_avail_update(pcm);
+        if (available < 0)
+            return (int) available;
+
+        // whole periods while running; the silence fill takes everything, so
+        // the ring buffer starts full
+        if (available == 0 || (useCallback && available < periodSize))
+            return 0;
+
+        const snd_pcm_channel_area_t* areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t frames = (snd_pcm_uframes_t) jmin((int) available, periodSize);
+
+        const int error = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames);
+        if (error < 0)
+            return error;
+
+        const int numFrames = (int) frames;
+        const ScopedTryLock sl(callbackLock);
+
+        if (useCallback && sl.isLocked() && callback != nullptr)
+            callback->audioDeviceIOCallback(nullptr, 0, renderBuffer.getArrayOfWritePointers(),
+                                            numChannels, numFrames);
+        else
+            renderBuffer.clear();
+
+        convertInto(areas, offset, numFrames);
+
+        // a short commit means the PCM ran out underneath
+        const snd_pcm_sframes_t committed = snd_pcm_mmap_commit(pcm, offset, frames);
+        if (committed < 0)
+            return (int) committed;
+        if ((snd_pcm_uframes_t) committed != frames)
+            return -EPIPE;
+    }
+}
+
+void AlsaMmapDevice::convertInto(const snd_pcm_channel_area_t* areas, snd_pcm_uframes_t offset, int numFrames)
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const snd_pcm_channel_area_t& area = areas[channel];
+        const float* source = renderBuffer.getReadPointer(channel);
+        // first and step are in bits
+        char* dest = static_cast<char*>(area.addr) + (area.first + offset * area.step) / 8;
+        const int stride = (int) (area.step / 8);
+
+        switch (format)
+        {
+            case SND_PCM_FORMAT_FLOAT:
+                for (int i = 0; i < numFrames; ++i, dest += stride)
+                    *reinterpret_cast<float*>(dest) = source[i];
+                break;
+            case SND_PCM_FORMAT_S32:
+                for (int i = 0; i < numFrames; ++i, dest += stride)
+                    *reinterpret_cast<int32*>(dest) = toInteger(source[i], 2147483647.0);
+                break;
+            case SND_PCM_FORMAT_S24:
+                for (int i = 0; i < numFrames; ++i, dest += stride)
+                    *reinterpret_cast<int32*>(dest) = toInteger(source[i], 8388607.0);
+                break;
+            default:
+                for (int i = 0; i < numFrames; ++i, dest += stride)
+                    *reinterpret_cast<int16*>(dest) = (int16) toInteger(source[i], 32767.0);
+                break;
+        }
+    }
+}
+//==============================================================================
+bool AlsaMmapDevice::recover(int error)
+{
+    if (error == -EPIPE)
+        ++numXRuns;
+
+    // handles underruns and suspends, and leaves the PCM prepared
+    if ((error = snd_pcm_recover(pcm, error, 1)) < 0)
+    {
+        lastError = describe("could not recover " + pcmName, error);
+        return false;
+    }
+
+    if (snd_pcm_state(pcm) == SND_PCM_STATE_RUNNING)
+        return true;
+
+    if ((error = writeAvailable(false)) < 0 || (error = snd_pcm_start(pcm)) < 0)
+    {
+        lastError = describe("could not restart " + pcmName, error);
+        return false;
+    }
+
+    return true;
+}
+
+String AlsaMmapDevice::fail(const String& message, int error)
+{
+    lastError = describe(message, error);
+    snd_pcm_close(pcm);
+    pcm = nullptr;
+    return lastError;
+}
+//==============================================================================
+const char* const AlsaMmapDeviceType::typeName = "ALSA mmap";
+
+AlsaMmapDeviceType::AlsaMmapDeviceType(const String& defaultPcmName, double rate, int period, int periods)
+    : AudioIODeviceType(typeName), sampleRate(rate), periodSize(period), numPeriods(periods)
+{
+    pcmNames.add(defaultPcmName);
+}
+
+void AlsaMmapDeviceType::scanForDevices()
+{
+    const String defaultPcmName = pcmNames[0];
+    pcmNames.clear();
+    pcmNames.add(defaultPcmName);
+
+    snd_pcm_info_t* info;
+    snd_pcm_info_alloca(&info);
+
+    for (int card = -1; snd_card_next(&card) == 0 && card >= 0;)
+    {
+        snd_ctl_t* control;
+        if (snd_ctl_open(&control, ("hw:" + String(card)).toRawUTF8(), 0) < 0)
+            continue;
+
+        for (int device = -1; snd_ctl_pcm_next_device(control, &device) == 0 && device >= 0;)
+        {
+            snd_pcm_info_set_device(info, (unsigned int) device);
+            snd_pcm_info_set_subdevice(info, 0);
+            snd_pcm_info_set_stream(info, SND_PCM_STREAM_PLAYBACK);
+
+            if (snd_ctl_pcm_info(control, info) == 0)
+                pcmNames.addIfNotAlreadyThere("hw:" + String(card) + "," + String(device));
+        }
+
+        snd_ctl_close(control);
+    }
+}
+
+StringArray AlsaMmapDeviceType::getDeviceNames(bool wantInputNames) const
+{
+    return wantInputNames ? StringArray() : pcmNames;
+}
+
+int AlsaMmapDeviceType::getDefaultDeviceIndex(bool forInput) const
+{
+    return forInput ? -1 : 0;
+}
+
+int AlsaMmapDeviceType::getIndexOfDevice(AudioIODevice* device, bool asInput) const
+{
+    return (asInput || device == nullptr) ? -1 : pcmNames.indexOf(device->getName());
+}
+
+bool AlsaMmapDeviceType::hasSeparateInputsAndOutputs() const
+{
+    return true;
+}
+
+AudioIODevice* AlsaMmapDeviceType::createDevice(const String& outputDeviceName, const String&)
+{
+    const String name = outputDeviceName.isNotEmpty() ? outputDeviceName : pcmNames[0];
+    return new AlsaMmapDevice(name, typeName, sampleRate, periodSize, numPeriods);
+}
+
+#endif /* JUCE_LINUX */
@@ -0,0 +1,169 @@
+//
+//  AlsaMmapDevice.hpp
+//
+//  ALSA playback device that writes straight into the driver's ring buffer
+//  through mmap, with the period size and count negotiated explicitly, for
+//  periods of 32 to 64 frames.
+//
+
+#ifndef AlsaMmapDevice_hpp
+#define AlsaMmapDevice_hpp
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#if JUCE_LINUX
+
+#include <alsa/asoundlib.h>
+
+/**
+ AlsaMmapDevice class: an output only AudioIODevice, so AudioDeviceManager
+ runs the callbacks exactly as with its own ALSA device.
+
+ open() asks the PCM for mmap access, the exact sample rate without ALSA's
+ resampler, the period size given as the buffer size, and the configured
+ number of periods, and reads back what the driver agreed to. The device
+ thread keeps the ring buffer full: it waits until a period is free, renders
+ one callback straight from AudioDeviceManager into a float buffer, converts
+ it into the mapped area and commits it. There is no intermediate buffer or
+ extra period in the device, so the output latency is the ring buffer.
+
+ The device thread never blocks on start() or stop(): it only tries the
+ callback lock, and plays a period of silence when it can't take it. An
+ underrun is counted as an xrun, the PCM is prepared again, refilled with
+ silence and restarted.
+ */
+class AlsaMmapDevice : public AudioIODevice, private Thread
+{
+public:
+    //==============================================================================
+    /**
+     @param pcmName ALSA PCM to open, e.g. hw:0,0 or hw:Loopback,0,0. Plugins
+                    such as dmix and plughw reblock or copy the audio, so a
+                    hw: device is needed for the small periods to mean much
+     @param typeName name of the AlsaMmapDeviceType creating it
+     @param sampleRate the only rate offered
+     @param periodSize frames per period, offered as the only buffer size
+     @param numPeriods periods in the ring buffer, 2 for the lowest latency
+     */
+    AlsaMmapDevice(const String& pcmName, const String& typeName,
+                   double sampleRate, int periodSize, int numPeriods);
+    ~AlsaMmapDevice();
+    //==============================================================================
+    StringArray getOutputChannelNames() override;
+    StringArray getInputChannelNames() override;
+    Array<double> getAvailableSampleRates() override;
+    Array<int> getAvailableBufferSizes() override;
+    int getDefaultBufferSize() override;
+
+    String open(const BigInteger& inputChannels, const BigInteger& outputChannels,
+                double sampleRate, int bufferSizeSamples) override;
+    void close() override;
+    bool isOpen() override;
+
+    void start(AudioIODeviceCallback* callback) override;
+    void stop() override;
+    bool isPlaying() override;
+    String getLastError() override;
+
+    int getCurrentBufferSizeSamples() override;
+    double getCurrentSampleRate() override;
+    int getCurrentBitDepth() override;
+    BigInteger getActiveOutputChannels() const override;
+    BigInteger getActiveInputChannels() const override;
+    /** @returns the frames still queued when a callback's period is committed,
+                 a period less than the ring buffer */
+    int getOutputLatencyInSamples() override;
+    int getInputLatencyInSamples() override;
+    int getXRunCount() const noexcept override;
+    //==============================================================================
+    /**
+     @returns what the driver agreed to, the latency it gives, and the lowest
+              the ring buffer has been since the device started
+     */
+    String getLatencyReport() const;
+
+private:
+    //==============================================================================
+    void run() override;
+    /**
+     fills every free frame of the ring buffer, with silence or the callback
+
+     @param useCallback false for silence only
+     @returns 0, or the negative error code for recover() to look at
+     */
+    int writeAvailable(bool useCallback);
+    /** converts numFrames of the render buffer into an mmap area at offset */
+    void convertInto(const snd_pcm_channel_area_t* areas, snd_pcm_uframes_t offset, int numFrames);
+    /**
+     restarts the PCM after an underrun or a suspend
+
+     @param error the negative error code ALSA returned
+     @returns false if the PCM could not be restarted
+     */
+    bool recover(int error);
+    /** sets lastError and closes the PCM */
+    String fail(const String& message, int error);
+    //==============================================================================
+    const String pcmName;
+    const double requestedSampleRate;
+    const int requestedPeriodSize, requestedNumPeriods;
+
+    snd_pcm_t* pcm = nullptr;
+    snd_pcm_format_t format = SND_PCM_FORMAT_UNKNOWN;
+    /** what the driver agreed to */
+    double sampleRate = 0;
+    int numChannels = 0, periodSize = 0, bufferSize = 0, numPeriods = 0;
+    /** one period, as AudioDeviceManager wants it */
+    AudioBuffer<float> renderBuffer;
+    String lastError;
+
+    CriticalSection callbackLock;
+    AudioIODeviceCallback* callback = nullptr;
+
+    std::atomic<int> numXRuns {0};
+    /** fewest frames left queued when the thread woke up, since the start */
+    std::atomic<int> lowestFill {0};
+
+    JUCE_DECLARE_NON_COPYABLE(AlsaMmapDevice)
+};
+
+//==============================================================================
+/**
+ AlsaMmapDeviceType class: makes AlsaMmapDevices for AudioDeviceManager, all
+ with the same rate, period size and period count.
+ */
+class AlsaMmapDeviceType : public AudioIODeviceType
+{
+public:
+    //==============================================================================
+    /** the type name to pass to AudioDeviceManager::setCurrentAudioDeviceType() */
+    static const char* const typeName;
+    //==============================================================================
+    /**
+     @param defaultPcmName PCM listed first, and opened by default
+     @param sampleRate sample rate of every device
+     @param periodSize frames per period of every device
+     @param numPeriods periods per ring buffer of every device
+     */
+    AlsaMmapDeviceType(const String& defaultPcmName, double sampleRate, int periodSize, int numPeriods);
+    //==============================================================================
+    void scanForDevices() override;
+    StringArray getDeviceNames(bool wantInputNames = false) const override;
+    int getDefaultDeviceIndex(bool forInput) const override;
+    int getIndexOfDevice(AudioIODevice* device, bool asInput) const override;
+    bool hasSeparateInputsAndOutputs() const override;
+    AudioIODevice* createDevice(const String& outputDeviceName, const String& inputDeviceName) override;
+
+private:
+    //==============================================================================
+    /** the default PCM, then a hw: PCM for each playback device the cards have */
+    StringArray pcmNames;
+    const double sampleRate;
+    const int periodSize, numPeriods;
+
+    JUCE_DECLARE_NON_COPYABLE(AlsaMmapDeviceType)
+};
+
+#endif /* JUCE_LINUX */
+
+#endif /* AlsaMmapDevice_hpp */
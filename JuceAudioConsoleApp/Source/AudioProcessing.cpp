@@ -8,15 +8,69 @@
 #include "AudioProcessing.hpp"
 
 //==============================================================================
-AudioProcessing::AudioProcessing()
+AudioProcessing::AudioProcessing(bool shouldOpenDevice, const RealtimeMode::Options& realtimeOptions,
+                                 const AudioDeviceOptions& deviceOptions)
+    : noiseSeed(Random::getSystemRandom().nextInt64())
 {
-    deviceManager.initialise(0,2, nullptr, true);
-    deviceManager.addAudioCallback(this);
+    realtimeMode.enable(realtimeOptions);
     
+    parameters.addParameter("cutoff", .4f, 0, 1, ParameterStore::Smoothing::perSample);
+    parameters.addParameter("lfo rate", .25f, .01f, 20, ParameterStore::Smoothing::perBlock);
+    parameters.addParameter("noise gain", .5f, 0, 1, ParameterStore::Smoothing::perSample);
+    parameters.addParameter("independent channels", 0, 0, 1, ParameterStore::Smoothing::none);
+    parameters.addParameter("midi synth", 0, 0, 1, ParameterStore::Smoothing::none);
+    parameters.addParameter("noise colour", 0, 0, 2, ParameterStore::Smoothing::none);
+    parameters.addParameter("lfo shape", 0, 0, 3, ParameterStore::Smoothing::none);
+    parameters.addParameter("control interval", 1, 1, 64, ParameterStore::Smoothing::none);
+    
+    synth.setWorkerPool(&workerPool);
+    
+    if (shouldOpenDevice)
+    {
+        if (deviceOptions.virtualClock)
+        {
+            VirtualClockDevice::Options clockOptions;
+            clockOptions.sampleRate = deviceOptions.sampleRate;
+            clockOptions.blockSize = deviceOptions.periodSize;
+            clockOptions.maxJitterMs = deviceOptions.maxJitterMs;
+            
+            deviceManager.addAudioDeviceType(new VirtualClockDeviceType(clockOptions));
+            AudioDeviceManager::AudioDeviceSetup setup;
+            setup.outputDeviceName = VirtualClockDeviceType::typeName;
+            setup.sampleRate = deviceOptions.sampleRate;
+            setup.bufferSize = deviceOptions.periodSize;
+            deviceError = deviceManager.initialise(0,2, nullptr, false, String(), &setup);
+        }
+#if JUCE_LINUX
+        else if (deviceOptions.mmapPcmName.isNotEmpty())
+        {
+            // the only device type, so nothing falls back to JUCE's ALSA device
+            deviceManager.addAudioDeviceType(new AlsaMmapDeviceType(deviceOptions.mmapPcmName, deviceOptions.sampleRate,
+                                                                    deviceOptions.periodSize, deviceOptions.numPeriods));
+            AudioDeviceManager::AudioDeviceSetup setup;
+            setup.outputDeviceName = deviceOptions.mmapPcmName;
+            setup.sampleRate = deviceOptions.sampleRate;
+            setup.bufferSize = deviceOptions.periodSize;
+            deviceError = deviceManager.initialise(0,2, nullptr, false, String(), &setup);
+        }
+        else
+#endif
+        {
+            deviceError = deviceManager.initialise(0,2, nullptr, true);
+        }
+        
+        const StringArray midiInputs (MidiInput::getDevices());
+        for (const String& name : midiInputs)
+            deviceManager.setMidiInputEnabled(name, true);
+        
+        deviceManager.addMidiInputCallback(String(), &synth);
+        deviceManager.addAudioCallback(this);
+    }
 }
 AudioProcessing::~AudioProcessing()
 {
     deviceManager.removeAudioCallback(this);
+    deviceManager.removeMidiInputCallback(String(), &synth);
 }
 
 //==============================================================================
@@ -28,31 +82,213 @@ void AudioProcessing::audioDeviceIOCallback(const float** inputChannelData,
                                             int numOutputChannels,
                                             int numSamples)
 {
+    realtimeMode.applyToCallbackThread();
     
-    for (int i = 0; i < numSamples; i++)
-    {
-        const float modSig = (sin(currRad) + 1) * .5f;
-        outputChannelData[0][i] = moogNonLin.filter(random.nextFloat()* 0.5 - 0.25,
-                                                    modSig,
-                                                    .4);
-        currRad += radsPerSec;
-    }
+    const int64 startTicks = callbackMonitor.beginCallback();
+    processBlock(outputChannelData, numOutputChannels, numSamples);
+    callbackMonitor.endCallback(startTicks, numSamples);
+}
+//==============================================================================
+void AudioProcessing::processBlock(float** outputChannelData, int numOutputChannels, int numSamples)
+{
+    if (maxBlockSize == 0 || numOutputChannels < 1 || voices.isEmpty())
+        return;
+    
+    // a decaying ladder or smoothing ramp must not fall onto slow subnormal arithmetic
+    const ScopedFlushDenormals flushDenormals;
+    
+    synth.beginCallback(numSamples);
     
-    if (numOutputChannels > 1)
+    for (int start = 0; start < numSamples; start += maxBlockSize)
     {
-        for (int channel = 1; channel < numOutputChannels; ++channel)
-            outputChannelData[channel] = outputChannelData[0];
+        const int blockSize = jmin(maxBlockSize, numSamples - start);
+        
+        parameters.beginBlock(blockSize);
+        
+        if (parameters.isChanging(lfoRateParameter))
+            lfo.setFrequency(parameters.getBlockValue(lfoRateParameter));
+        
+        if (parameters.isChanging(lfoShapeParameter))
+            lfo.setShape((BlockLFO::Shape) roundToInt(parameters.getBlockValue(lfoShapeParameter)));
+        
+        // the buffer holds the settled cutoff between changes, so the ladder
+        // sees a constant side chain and keeps its coefficients
+        if (parameters.isChanging(cutoffParameter))
+            parameters.fillBuffer(cutoffParameter, cutoffBuffer, maxBlockSize);
+        
+        if (parameters.isChanging(noiseGainParameter))
+            parameters.fillBuffer(noiseGainParameter, noiseGainBuffer, blockSize);
+        
+        // the ladders only read the side chains once per control interval, so
+        // the LFO is only worked out that often
+        const int controlInterval = roundToInt(parameters.getBlockValue(controlIntervalParameter));
+        
+        if (parameters.isChanging(controlIntervalParameter))
+            for (Voice* voice : voices)
+                voice->filter.setControlInterval(controlInterval);
+        
+        if (controlInterval > 1)
+        {
+            for (int i = 0; i < blockSize; i += controlInterval)
+            {
+                const int spanSize = jmin(controlInterval, blockSize - i);
+                FloatVectorOperations::fill(resonanceBuffer + i, lfo.advance(spanSize), spanSize);
+            }
+        }
+        else
+        {
+            lfo.process(resonanceBuffer, blockSize);
+        }
+        
+        // the LFO swings [-1, 1], resonance wants [0, 1]
+        FloatVectorOperations::add(resonanceBuffer, 1.0f, blockSize);
+        FloatVectorOperations::multiply(resonanceBuffer, .5f, blockSize);
+        
+        // every voice renders straight into its own output channel, the rest
+        // of the channels are copies of channel 0
+        const bool independent = parameters.getBlockValue(channelModeParameter) >= .5f;
+        int numVoices = independent ? jmin(numOutputChannels, voices.size()) : 1;
+        
+        const bool synthIsSource = parameters.getBlockValue(sourceParameter) >= .5f;
+        
+        if (synthIsSource)
+        {
+            // voices left sounding when the synth was switched away from
+            // missed their note offs, so it starts again from silence
+            if (! synthWasSource)
+                synth.reset();
+            
+            // the synth is mono: its events are still taken in order however
+            // the callback is split
+            numVoices = 1;
+            FloatVectorOperations::clear(outputChannelData[0] + start, blockSize);
+            synth.render(outputChannelData[0] + start, start, blockSize,
+                         parameters.getBlockValue(cutoffParameter), resonanceBuffer[0]);
+        }
+        else
+        {
+            // notes played while the noise is the source are dropped, not
+            // started unheard
+            synth.skip(start, blockSize);
+            
+            VoiceJobContext context { this, outputChannelData, start, blockSize };
+            workerPool.run(renderVoiceJob, &context, numVoices);
+        }
+        
+        synthWasSource = synthIsSource;
+        
+        for (int channel = numVoices; channel < numOutputChannels; ++channel)
+            FloatVectorOperations::copy(outputChannelData[channel] + start, outputChannelData[0] + start, blockSize);
     }
 }
+
+void AudioProcessing::renderVoice(Voice& voice, float* output, int blockSize)
+{
+    float* const noiseBuffer = voice.noiseBuffer;
+    voice.noise.setColour((BlockNoise::Colour) roundToInt(parameters.getBlockValue(noiseColourParameter)));
+    voice.noise.fill(noiseBuffer, blockSize);
+    
+    if (parameters.isChanging(noiseGainParameter))
+        FloatVectorOperations::multiply(noiseBuffer, noiseGainBuffer, blockSize);
+    else
+        FloatVectorOperations::multiply(noiseBuffer, parameters.getBlockValue(noiseGainParameter), blockSize);
+    
+    voice.filter.processBlock(noiseBuffer, output, blockSize, resonanceBuffer, cutoffBuffer);
+}
+
+void AudioProcessing::renderVoiceJob(void* context, int jobIndex)
+{
+    const ScopedFlushDenormals flushDenormals;
+    const VoiceJobContext& job = *static_cast<VoiceJobContext*>(context);
+    job.processor->renderVoice(*job.processor->voices.getUnchecked(jobIndex),
+                               job.outputChannelData[jobIndex] + job.startSample, job.blockSize);
+}
 //==============================================================================
 void AudioProcessing::audioDeviceAboutToStart(AudioIODevice* device)
 {
-    double sampleRate = device->getCurrentSampleRate();
-    moogNonLin.init(sampleRate);
-    radsPerSec = 2 * float_Pi * modFreq / sampleRate;
+    // a reopened device calls back on a new thread, which needs setting up again
+    realtimeMode.rearm();
+    
+    prepareToPlay(device->getCurrentSampleRate(), device->getCurrentBufferSizeSamples(),
+                  device->getActiveOutputChannels().countNumberOfSetBits());
+    callbackMonitor.prepare(device->getCurrentSampleRate());
+}
+//==============================================================================
+void AudioProcessing::prepareToPlay(double newSampleRate, int blockSize, int numChannels)
+{
+    sampleRate = newSampleRate;
+    parameters.prepare(sampleRate, .05);
+    
+    maxBlockSize = jmax(1, blockSize);
+    
+    voices.clear();
+    for (int channel = 0; channel < jmax(1, numChannels); ++channel)
+    {
+        Voice* voice = voices.add(new Voice());
+        voice->noiseBuffer.allocate(maxBlockSize, true);
+        voice->filter.init(sampleRate);
+        voice->filter.setSaturation(LadderSaturation::rational);
+        voice->filter.setControlInterval(roundToInt(parameters.getBlockValue(controlIntervalParameter)));
+        voice->noise.setSeed((uint64) (noiseSeed + channel));
+    }
+    
+    synth.prepare(sampleRate, maxBlockSize);
+    resonanceBuffer.allocate(maxBlockSize, true);
+    noiseGainBuffer.allocate(maxBlockSize, true);
+    cutoffBuffer.allocate(maxBlockSize, false);
+    parameters.fillBuffer(cutoffParameter, cutoffBuffer, maxBlockSize);
+    
+    // if waking the workers makes a block late, half its budget is a sign of it
+    workerPool.setDeadline(.5 * maxBlockSize / sampleRate);
+    
+    if (realtimeMode.isEnabled())
+    {
+        for (Voice* voice : voices)
+            RealtimeMode::prefault(voice->noiseBuffer, maxBlockSize * sizeof(float));
+        
+        RealtimeMode::prefault(resonanceBuffer, maxBlockSize * sizeof(float));
+        RealtimeMode::prefault(noiseGainBuffer, maxBlockSize * sizeof(float));
+        RealtimeMode::prefault(cutoffBuffer, maxBlockSize * sizeof(float));
+    }
+    
+    lfo.init(sampleRate);
+    lfo.setFrequency(parameters.getBlockValue(lfoRateParameter));
+    lfo.setShape((BlockLFO::Shape) roundToInt(parameters.getBlockValue(lfoShapeParameter)));
+    lfo.setPhase(0);
 }
 //==============================================================================
 void AudioProcessing::audioDeviceStopped()
 {
 }
+//==============================================================================
+String AudioProcessing::getDeviceReport() const
+{
+    AudioIODevice* device = deviceManager.getCurrentAudioDevice();
+    
+    if (device == nullptr)
+        return "no audio device open" + (deviceError.isNotEmpty() ? ": " + deviceError : String()) + "\n";
+    
+    if (VirtualClockDevice* clockDevice = dynamic_cast<VirtualClockDevice*>(device))
+        return clockDevice->getClockReport();
+    
+#if JUCE_LINUX
+    if (AlsaMmapDevice* mmapDevice = dynamic_cast<AlsaMmapDevice*>(device))
+        return mmapDevice->getLatencyReport();
+#endif
+    
+    String report;
+    report << device->getName() << " (" << device->getTypeName() << "): "
+           << String(device->getCurrentSampleRate(), 0) << " Hz, buffer "
+           << device->getCurrentBufferSizeSamples() << " frames, output latency "
+           << device->getOutputLatencyInSamples() << " frames\n";
+    return report;
+}
+
+int AudioProcessing::getDeviceXRunCount() const
+{
+    if (AudioIODevice* device = deviceManager.getCurrentAudioDevice())
+        return device->getXRunCount();
+    
+    return -1;
+}
 
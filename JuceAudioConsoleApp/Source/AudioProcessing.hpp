@@ -11,14 +11,107 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "../joeyMoogClasses/LinearJoeyMoogSC.hpp"
 #include "../joeyMoogClasses/NonLinearJoeyMoogSC.hpp"
+#include "../joeyMoogClasses/BlockNoise.hpp"
+#include "../joeyMoogClasses/BlockLFO.hpp"
+#include "CallbackMonitor.hpp"
+#include "ParameterStore.hpp"
+#include "LadderSynth.hpp"
+#include "ChainWorkerPool.hpp"
+#include "RealtimeMode.hpp"
+#include "AlsaMmapDevice.hpp"
+#include "VirtualClockDevice.hpp"
+
+/** the output device AudioProcessing opens */
+struct AudioDeviceOptions
+{
+    /** empty for JUCE's default device, otherwise the ALSA PCM to drive with
+        an AlsaMmapDevice, e.g. hw:0,0 */
+    String mmapPcmName;
+    /** true to run from a VirtualClockDevice instead of any sound card */
+    bool virtualClock = false;
+    /** most the virtual clock wakes a callback late by */
+    double maxJitterMs = 0;
+    double sampleRate = 48000;
+    /** frames per period, and so per callback, for every device type */
+    int periodSize = 64;
+    int numPeriods = 2;
+};
 
 class AudioProcessing : public AudioIODeviceCallback
 {
 public:
     //==============================================================================
-    AudioProcessing();
+    /** indices into getParameters() */
+    enum ParameterIndex
+    {
+        cutoffParameter = 0,    /**< ladder cutoff side chain, 0 to 1 */
+        lfoRateParameter,       /**< resonance LFO rate in Hz */
+        noiseGainParameter,     /**< peak to peak level of the noise into the ladder */
+        channelModeParameter,   /**< 0 copies channel 0 to every output, 1 runs an
+                                     independent ladder and noise source per output */
+        sourceParameter,        /**< 0 filters noise, 1 plays the MIDI synth */
+        noiseColourParameter,   /**< 0 white, 1 pink, 2 brown noise */
+        lfoShapeParameter,      /**< resonance LFO BlockLFO::Shape: 0 sine, 1 triangle,
+                                     2 saw, 3 sample and hold */
+        controlIntervalParameter /**< samples between modulation updates, 1 for every
+                                      sample, see MoogLadder::setControlInterval() */
+    };
+    //==============================================================================
+    /**
+     @param shouldOpenDevice true to open the default output device and run from its
+                             callback, false to drive prepareToPlay() and processBlock()
+                             directly (e.g. to render offline)
+     @param realtimeOptions memory locking and audio thread scheduling, applied
+                            before the device is opened
+     @param deviceOptions which output device to open, if one is
+     */
+    AudioProcessing(bool shouldOpenDevice = true,
+                    const RealtimeMode::Options& realtimeOptions = RealtimeMode::Options(),
+                    const AudioDeviceOptions& deviceOptions = AudioDeviceOptions());
     ~AudioProcessing();
     //==============================================================================
+    /**
+     sets up the DSP chain and its buffers. Not real time safe.
+     
+     @param newSampleRate sample rate to run at
+     @param blockSize largest numSamples processBlock() is expected to be given;
+                      larger calls are split up
+     @param numChannels number of outputs that can each have their own ladder
+     */
+    void prepareToPlay(double newSampleRate, int blockSize, int numChannels = 2);
+    
+    /**
+     seeds the noise of the following prepareToPlay(), so a render can be
+     repeated exactly. Otherwise every run is seeded differently.
+     
+     @param seed seed of channel 0's noise, each channel after uses the next value
+     */
+    void setNoiseSeed(int64 seed) { noiseSeed = seed; }
+    
+    /**
+     runs the DSP chain, filling every output channel
+     
+     @param outputChannelData numOutputChannels buffers of numSamples
+     @param numOutputChannels number of output channels
+     @param numSamples number of samples, any size
+     */
+    void processBlock(float** outputChannelData, int numOutputChannels, int numSamples);
+    //==============================================================================
+    /** @returns the parameters, safe to set from any one control thread while the device runs */
+    ParameterStore& getParameters() { return parameters; }
+    
+    /** @returns the timing of the device callbacks */
+    CallbackMonitor& getCallbackMonitor() { return callbackMonitor; }
+    
+    /** @returns what the realtime mode managed to set up */
+    const RealtimeMode& getRealtimeMode() const { return realtimeMode; }
+    
+    /** @returns the open device with its buffer size and latency, or why none is open */
+    String getDeviceReport() const;
+    
+    /** @returns the xruns the device itself has counted, or -1 if it can't tell */
+    int getDeviceXRunCount() const;
+    //==============================================================================
     void audioDeviceIOCallback(const float** inputChannelData,
                                int numInputChannels,
                                float** outputChannelData,
@@ -32,12 +125,59 @@ public:
     
 private:
     //==============================================================================
+    /** enabled before the device opens, so every buffer it and prepareToPlay() allocate is locked */
+    RealtimeMode realtimeMode;
     AudioDeviceManager deviceManager;
-    JoeyNonLinearMoogSC moogNonLin;
-    Random random;
-    float modFreq    = .25;
-    float radsPerSec = 0;
-    float currRad    = 0;
+    /** why the device did not open, if it didn't */
+    String deviceError;
+    CallbackMonitor callbackMonitor;
+    ParameterStore parameters;
+    /** runs the independent channels' voices and the synth's voices on every core */
+    ChainWorkerPool workerPool;
+    LadderSynth synth;
+    /** true if the synth was the source in the last block, audio thread only */
+    bool synthWasSource = false;
+    /** one ladder with its own noise source, so independent channels are decorrelated */
+    struct Voice
+    {
+        JoeyNonLinearMoogSC filter;
+        BlockNoise noise;
+        /** the voice's excitation, its own so voices can render at the same time */
+        HeapBlock<float> noiseBuffer;
+    };
+    
+    /** what renderVoiceJob() needs from processBlock() */
+    struct VoiceJobContext
+    {
+        AudioProcessing* processor;
+        float** outputChannelData;
+        int startSample, blockSize;
+    };
+    
+    /**
+     filters a block of the voice's noise. Only reads the shared buffers, so
+     different voices can be rendered at the same time.
+     
+     @param voice voice to run
+     @param output blockSize samples to write
+     @param blockSize number of samples, no more than maxBlockSize
+     */
+    void renderVoice(Voice& voice, float* output, int blockSize);
+    
+    /** ChainWorkerPool job: renders voice jobIndex into its output channel */
+    static void renderVoiceJob(void* context, int jobIndex);
+    
+    /** one per output channel, allocated by prepareToPlay() */
+    OwnedArray<Voice> voices;
+    /** per block resonance and cutoff side chains */
+    HeapBlock<float> resonanceBuffer, cutoffBuffer;
+    /** per sample noise gain while it is being smoothed */
+    HeapBlock<float> noiseGainBuffer;
+    int maxBlockSize = 0;
+    int64 noiseSeed;
+    double sampleRate = 44100;
+    /** resonance modulation, phase wrapped so it holds over weeks of uptime */
+    BlockLFO lfo;
 };
 
 
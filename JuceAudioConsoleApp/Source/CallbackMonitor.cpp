@@ -0,0 +1,151 @@
+//
+//  CallbackMonitor.cpp
+//
+
+#include "CallbackMonitor.hpp"
+
+//==============================================================================
+CallbackMonitor::CallbackMonitor() : Thread("Callback Monitor")
+{
+    timings.allocate(fifo.getTotalSize(), true);
+}
+
+CallbackMonitor::~CallbackMonitor()
+{
+    stopThread(1000);
+}
+//==============================================================================
+void CallbackMonitor::prepare(double sampleRate)
+{
+    ticksPerSample = Time::getHighResolutionTicksPerSecond() / sampleRate;
+    requestReset();
+
+    if (! isThreadRunning())
+        startThread(3);
+}
+//==============================================================================
+void CallbackMonitor::endCallback(int64 startTicks, int numSamples) noexcept
+{
+    const Timing timing { Time::getHighResolutionTicks() - startTicks,
+                          (int64) (numSamples * ticksPerSample) };
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 + size2 < 1)
+    {
+        ++numDropped;
+        return;
+    }
+
+    timings[size1 > 0 ? start1 : start2] = timing;
+    fifo.finishedWrite(1);
+}
+//==============================================================================
+void CallbackMonitor::requestReport(bool withHistogram)
+{
+    histogramRequested = withHistogram;
+    reportRequested = true;
+    notify();
+}
+
+void CallbackMonitor::requestReset()
+{
+    resetRequested = true;
+    notify();
+}
+//==============================================================================
+void CallbackMonitor::run()
+{
+    while (! threadShouldExit())
+    {
+        wait(100);
+        drainFifo();
+
+        if (resetRequested.exchange(false))
+        {
+            stats = Stats();
+            numDropped = 0;
+        }
+
+        if (reportRequested.exchange(false))
+            printReport(histogramRequested);
+    }
+}
+
+void CallbackMonitor::drainFifo()
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1 + size2; ++i)
+    {
+        const Timing& timing = timings[i < size1 ? start1 + i : start2 + i - size1];
+        const double load = timing.budgetTicks > 0 ? timing.durationTicks / (double) timing.budgetTicks : 0;
+
+        if (stats.numCallbacks == 0 || timing.durationTicks < stats.minTicks)
+            stats.minTicks = timing.durationTicks;
+        stats.maxTicks = jmax(stats.maxTicks, timing.durationTicks);
+        stats.maxLoad = jmax(stats.maxLoad, load);
+        stats.sumTicks += timing.durationTicks;
+        stats.sumLoad += load;
+        ++stats.numCallbacks;
+
+        if (timing.durationTicks > timing.budgetTicks)
+            ++stats.numOverruns;
+
+        ++stats.loadBins[jmin(numLoadBins, (int) (load * 100))];
+    }
+
+    fifo.finishedRead(size1 + size2);
+}
+//==============================================================================
+double CallbackMonitor::getLoadPercentile(double fraction) const
+{
+    const int64 rank = (int64) std::ceil(fraction * stats.numCallbacks);
+    int64 count = 0;
+
+    for (int bin = 0; bin < numLoadBins; ++bin)
+    {
+        count += stats.loadBins[bin];
+        if (count >= rank)
+            return (bin + 1) / 100.0;
+    }
+    return stats.maxLoad;
+}
+
+void CallbackMonitor::printReport(bool withHistogram) const
+{
+    if (stats.numCallbacks == 0)
+    {
+        printf("no callbacks timed yet\n");
+        return;
+    }
+
+    const double microsPerTick = 1.0e6 / Time::getHighResolutionTicksPerSecond();
+
+    printf("callbacks %lld, deadline overruns %lld, dropped records %lld\n",
+           (long long) stats.numCallbacks, (long long) stats.numOverruns, (long long) numDropped.load());
+    printf("duration us: min %.1f mean %.1f max %.1f\n",
+           stats.minTicks * microsPerTick,
+           stats.sumTicks / stats.numCallbacks * microsPerTick,
+           stats.maxTicks * microsPerTick);
+    printf("load %% of budget: mean %.1f p99 <= %.0f max %.1f\n",
+           100 * stats.sumLoad / stats.numCallbacks,
+           100 * getLoadPercentile(0.99),
+           100 * stats.maxLoad);
+
+    if (! withHistogram)
+        return;
+
+    for (int bin = 0; bin <= numLoadBins; ++bin)
+    {
+        if (stats.loadBins[bin] == 0)
+            continue;
+
+        if (bin == numLoadBins)
+            printf("  >=%3d%% %lld\n", numLoadBins, (long long) stats.loadBins[bin]);
+        else
+            printf("  %3d%%-%3d%% %lld\n", bin, bin + 1, (long long) stats.loadBins[bin]);
+    }
+}
@@ -0,0 +1,108 @@
+//
+//  CallbackMonitor.hpp
+//
+//  Times every audio callback against its deadline and reports the load from
+//  a background thread, without the audio thread allocating or locking.
+//
+
+#ifndef CallbackMonitor_hpp
+#define CallbackMonitor_hpp
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+ CallbackMonitor class: the audio thread brackets each callback with
+ beginCallback() and endCallback(), which push one timing record into a
+ single producer, single consumer AbstractFifo. The reporter thread drains
+ the fifo into the statistics and prints them when asked; those statistics
+ are only ever touched by the reporter thread.
+
+ The budget of a callback is the time its numSamples take to play, and a
+ callback running over it is counted as a deadline overrun.
+ */
+class CallbackMonitor : private Thread
+{
+public:
+    //==============================================================================
+    CallbackMonitor();
+    ~CallbackMonitor();
+    //==============================================================================
+    /**
+     sets the sample rate budgets are taken from and starts the reporter thread.
+     Not real time safe, call before the callbacks start.
+
+     @param sampleRate sample rate of the device
+     */
+    void prepare(double sampleRate);
+    //==============================================================================
+    /** @returns the start time to pass to endCallback(). Wait-free */
+    int64 beginCallback() const noexcept { return Time::getHighResolutionTicks(); }
+
+    /**
+     records one callback. Wait-free: if the fifo is full the record is dropped
+     and counted instead.
+
+     @param startTicks what beginCallback() returned
+     @param numSamples number of samples the callback produced
+     */
+    void endCallback(int64 startTicks, int numSamples) noexcept;
+    //==============================================================================
+    /**
+     asks the reporter thread to print the statistics
+
+     @param withHistogram true to print the load histogram too
+     */
+    void requestReport(bool withHistogram);
+
+    /** asks the reporter thread to clear the statistics */
+    void requestReset();
+
+private:
+    //==============================================================================
+    /** one callback as seen by the audio thread */
+    struct Timing
+    {
+        int64 durationTicks;
+        int64 budgetTicks;
+    };
+
+    /** number of histogram bins, each 1% of the budget wide */
+    static const int numLoadBins = 200;
+
+    /** accumulated by the reporter thread */
+    struct Stats
+    {
+        int64 numCallbacks = 0;
+        int64 numOverruns = 0;
+        int64 minTicks = 0, maxTicks = 0;
+        double sumTicks = 0, sumLoad = 0;
+        double maxLoad = 0;
+        /** callbacks per 1% of budget, the last bin holds everything over 200% */
+        int64 loadBins[numLoadBins + 1] = {};
+    };
+    //==============================================================================
+    void run() override;
+    /** moves every pending record from the fifo into stats */
+    void drainFifo();
+    /** prints stats to stdout */
+    void printReport(bool withHistogram) const;
+    /** @returns the load that fraction of the callbacks are at or below */
+    double getLoadPercentile(double fraction) const;
+    //==============================================================================
+    AbstractFifo fifo {1024};
+    HeapBlock<Timing> timings;
+    /** records the audio thread could not push */
+    std::atomic<int64> numDropped {0};
+    /** high resolution ticks per sample at the device rate */
+    double ticksPerSample = 0;
+
+    std::atomic<bool> reportRequested {false};
+    std::atomic<bool> histogramRequested {false};
+    std::atomic<bool> resetRequested {false};
+
+    Stats stats;
+
+    JUCE_DECLARE_NON_COPYABLE(CallbackMonitor)
+};
+
+#endif /* CallbackMonitor_hpp */
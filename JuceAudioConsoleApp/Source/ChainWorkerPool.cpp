@@ -0,0 +1,198 @@
+//
+//  ChainWorkerPool.cpp
+//
+
+#include "ChainWorkerPool.hpp"
+
+#if JUCE_INTEL
+ #include <emmintrin.h>
+#endif
+
+namespace
+{
+    /** runs after a fallback before the workers are tried again */
+    const int fallbackLength = 256;
+
+    /** tells the core this is a spin wait, so it saves power and lets a
+        hyperthreaded sibling run */
+    inline void spinPause() noexcept
+    {
+#if JUCE_INTEL
+        _mm_pause();
+#elif JUCE_ARM && (defined(__aarch64__) || defined(__ARM_ARCH_7A__))
+        __asm__ __volatile__ ("yield");
+#endif
+    }
+}
+//==============================================================================
+ChainWorkerPool::ChainWorkerPool(int numWorkers)
+{
+    if (numWorkers < 0)
+        numWorkers = SystemStats::getNumCpus() - 1;
+
+    numRanges = jmax(0, numWorkers) + 1;
+    for (int i = 0; i < numRanges; ++i)
+        ranges.add(new Range());
+
+    setSpinTime(.0002);
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        Worker* worker = workers.add(new Worker(*this, i + 1));
+        // just under the audio thread, which should win if they share a core
+        worker->startThread(9);
+    }
+}
+
+ChainWorkerPool::~ChainWorkerPool()
+{
+    for (Worker* worker : workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->notify();
+    }
+
+    for (Worker* worker : workers)
+        worker->stopThread(1000);
+
+    workers.clear();
+}
+//==============================================================================
+void ChainWorkerPool::setDeadline(double seconds)
+{
+    deadlineTicks = (int64) (jmax(0.0, seconds) * Time::getHighResolutionTicksPerSecond());
+}
+
+void ChainWorkerPool::setSpinTime(double seconds)
+{
+    spinTicks = (int64) (jmax(0.0, seconds) * Time::getHighResolutionTicksPerSecond());
+}
+//==============================================================================
+void ChainWorkerPool::run(JobFunction job, void* context, int numJobs) noexcept
+{
+    if (numJobs <= 0)
+        return;
+
+    if (workers.isEmpty() || numJobs == 1 || fallbackRunsLeft > 0)
+    {
+        fallbackRunsLeft = jmax(0, fallbackRunsLeft - 1);
+        runSerially(job, context, numJobs);
+        return;
+    }
+
+    const int64 startTicks = Time::getHighResolutionTicks();
+
+    // deal the jobs out evenly, the first ranges taking one extra
+    const int perRange = numJobs / numRanges, extra = numJobs % numRanges;
+    for (int i = 0, start = 0; i < numRanges; ++i)
+    {
+        const int size = perRange + (i < extra ? 1 : 0);
+        Range& range = *ranges.getUnchecked(i);
+        range.next.store(start, std::memory_order_relaxed);
+        range.end = start + size;
+        start += size;
+    }
+
+    currentJob = job;
+    currentContext = context;
+    jobsRemaining.store(numJobs, std::memory_order_relaxed);
+    jobsByWorkers.store(0, std::memory_order_relaxed);
+
+    // publishes everything above to the workers that see the new generation
+    runOpen = true;
+    ++generation;
+
+    for (Worker* worker : workers)
+        if (worker->parked.load())
+            worker->notify();
+
+    work(0);
+
+    // the jobs left are running on workers right now, so this wait is short
+    while (jobsRemaining.load() > 0)
+        spinPause();
+
+    runOpen = false;
+    while (numActiveWorkers.load() > 0)
+        spinPause();
+
+    if (deadlineTicks > 0 && Time::getHighResolutionTicks() - startTicks > deadlineTicks
+        && jobsByWorkers.load() * 2 < numJobs)
+    {
+        fallbackRunsLeft = fallbackLength;
+        ++numFallbacks;
+    }
+}
+
+int ChainWorkerPool::work(int firstRange) noexcept
+{
+    int numDone = 0;
+
+    for (int i = 0; i < numRanges; ++i)
+    {
+        Range& range = *ranges.getUnchecked((firstRange + i) % numRanges);
+
+        for (;;)
+        {
+            // a claim past the end is harmless, the range only ever grows its next
+            const int index = range.next.fetch_add(1);
+            if (index >= range.end)
+                break;
+
+            currentJob(currentContext, index);
+            ++numDone;
+            jobsRemaining.fetch_sub(1);
+        }
+    }
+
+    return numDone;
+}
+
+void ChainWorkerPool::runSerially(JobFunction job, void* context, int numJobs) noexcept
+{
+    for (int i = 0; i < numJobs; ++i)
+        job(context, i);
+}
+//==============================================================================
+ChainWorkerPool::Worker::Worker(ChainWorkerPool& owner, int index)
+    : Thread("Chain Worker " + String(index)), pool(owner), rangeIndex(index)
+{
+}
+
+void ChainWorkerPool::Worker::run()
+{
+    uint32 seenGeneration = pool.generation.load();
+
+    while (! threadShouldExit())
+    {
+        // spin for the next run, then park until run() or the destructor notifies
+        const int64 spinEnd = Time::getHighResolutionTicks() + pool.spinTicks.load();
+
+        while (pool.generation.load() == seenGeneration && Time::getHighResolutionTicks() < spinEnd)
+            for (int i = 0; i < 64; ++i)
+                spinPause();
+
+        if (pool.generation.load() == seenGeneration)
+        {
+            // run() bumps the generation before reading parked, and this sets
+            // parked before reading the generation, so one of them sees the other
+            parked = true;
+            if (pool.generation.load() == seenGeneration)
+                wait(100);
+            parked = false;
+            continue;
+        }
+
+        seenGeneration = pool.generation.load();
+
+        // run() waits for active workers before it returns, and this checks the
+        // run is still open after counting itself in, so it never joins a
+        // finished run or one that has been dealt out again
+        ++pool.numActiveWorkers;
+
+        if (pool.runOpen.load() && pool.generation.load() == seenGeneration)
+            pool.jobsByWorkers.fetch_add(pool.work(rangeIndex));
+
+        --pool.numActiveWorkers;
+    }
+}
@@ -0,0 +1,152 @@
+//
+//  ChainWorkerPool.hpp
+//
+//  Splits independent filter chains across the spare cores inside an audio
+//  callback, without the audio thread allocating or waiting on a lock.
+//
+
+#ifndef ChainWorkerPool_hpp
+#define ChainWorkerPool_hpp
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+ ChainWorkerPool class: run() calls a job once for each index in [0, numJobs),
+ on the calling thread and on the pool's worker threads at the same time, and
+ returns once every call has finished.
+
+ The indices are dealt out in contiguous ranges, one per thread. Each thread
+ claims indices from its own range with an atomic increment and, when that
+ is empty, steals from the others' ranges the same way, so a worker that
+ wakes late or gets preempted only costs the jobs it had already claimed.
+ The caller takes part too, and on its own would simply work through every
+ range.
+
+ Between calls the workers spin for a short while, then park on their thread
+ event. run() only signals the workers that have parked.
+
+ If a parallel run takes longer than the deadline, and the workers did less
+ than half of its jobs, the wake ups are costing more than they give. The
+ pool then runs everything on the calling thread for a while before trying
+ the workers again.
+
+ Every thread and range is allocated by the constructor, and run() neither
+ allocates nor locks unless it has to wake a parked worker.
+ */
+class ChainWorkerPool
+{
+public:
+    //==============================================================================
+    /**
+     a job: called with the context given to run() and the index of the chain
+     to process. Must be safe to call for different indices at the same time.
+     */
+    typedef void (*JobFunction)(void* context, int jobIndex);
+    //==============================================================================
+    /**
+     starts the workers. Not real time safe.
+
+     @param numWorkers threads besides the caller's, or -1 for one per spare core
+     */
+    ChainWorkerPool(int numWorkers = -1);
+    /** stops the workers, which must not be inside run() */
+    ~ChainWorkerPool();
+    //==============================================================================
+    /**
+     sets how long a parallel run() may take before the pool falls back to the
+     calling thread, e.g. part of the callback's budget
+
+     @param seconds deadline of one run(), 0 to never fall back
+     */
+    void setDeadline(double seconds);
+
+    /**
+     sets how long idle workers spin before parking. Longer wakes them faster
+     for the next run() at the cost of burning their core.
+
+     @param seconds time to spin
+     */
+    void setSpinTime(double seconds);
+    //==============================================================================
+    /**
+     calls job(context, i) for every i in [0, numJobs) and waits for them all.
+     Call from one thread at a time, normally the audio thread. Jobs run on
+     worker threads, so per-thread FPU state such as ScopedFlushDenormals
+     must be set inside the job.
+
+     @param job job to call
+     @param context passed to every call
+     @param numJobs number of calls
+     */
+    void run(JobFunction job, void* context, int numJobs) noexcept;
+    //==============================================================================
+    /** @returns the number of worker threads, not counting the caller */
+    int getNumWorkers() const { return workers.size(); }
+
+    /** @returns how many times a run overran the deadline and made the pool fall back */
+    int64 getNumFallbacks() const { return numFallbacks.load(); }
+
+private:
+    //==============================================================================
+    /** a contiguous run of job indices, claimed from the front */
+    struct Range
+    {
+        std::atomic<int> next {0};
+        int end = 0;
+    };
+
+    /** a worker thread, owning the range with its index */
+    class Worker : public Thread
+    {
+    public:
+        Worker(ChainWorkerPool& owner, int rangeIndex);
+        void run() override;
+
+        /** true while parked and waiting for notify() */
+        std::atomic<bool> parked {false};
+
+    private:
+        ChainWorkerPool& pool;
+        const int rangeIndex;
+    };
+    //==============================================================================
+    /**
+     claims and runs jobs from the range at firstRange, then steals from the others
+
+     @returns the number of jobs run
+     */
+    int work(int firstRange) noexcept;
+    /** runs every job on the calling thread */
+    void runSerially(JobFunction job, void* context, int numJobs) noexcept;
+    //==============================================================================
+    OwnedArray<Worker> workers;
+    /** range 0 is the caller's, range i + 1 is worker i's. Each is its own
+        allocation, so threads claiming from different ranges do not share a
+        cache line */
+    OwnedArray<Range> ranges;
+    int numRanges = 1;
+
+    /** the run in progress */
+    JobFunction currentJob = nullptr;
+    void* currentContext = nullptr;
+    /** bumped by every parallel run() to wake the workers */
+    std::atomic<uint32> generation {0};
+    /** false once a run has finished, so a late worker does not join it */
+    std::atomic<bool> runOpen {false};
+    /** workers inside the run, waited for before run() returns */
+    std::atomic<int> numActiveWorkers {0};
+    /** jobs of the current run not finished yet */
+    std::atomic<int> jobsRemaining {0};
+    /** jobs of the current run done by the workers */
+    std::atomic<int> jobsByWorkers {0};
+
+    int64 deadlineTicks = 0;
+    std::atomic<int64> spinTicks {0};
+    /** runs left to do on the calling thread after a fallback */
+    int fallbackRunsLeft = 0;
+    std::atomic<int64> numFallbacks {0};
+
+    JUCE_DECLARE_NON_COPYABLE(ChainWorkerPool)
+};
+
+#endif /* ChainWorkerPool_hpp */
@@ -0,0 +1,246 @@
+//
+//  GridRenderer.cpp
+//
+
+#include "GridRenderer.hpp"
+#include "../joeyMoogClasses/BlockLFO.hpp"
+
+namespace
+{
+    /** samples the filter and LFO are run for at a time */
+    const int renderBlockSize = 256;
+
+    /**
+     in place radix 2 FFT of size points, size a power of two
+
+     @param twiddleCos cos(2*pi*k/size) for k in [0, size/2)
+     @param twiddleSin sin(2*pi*k/size) for k in [0, size/2)
+     */
+    void fft(double* re, double* im, int size, const double* twiddleCos, const double* twiddleSin)
+    {
+        for (int i = 1, j = 0; i < size; ++i)
+        {
+            int bit = size >> 1;
+            for (; (j & bit) != 0; bit >>= 1)
+                j ^= bit;
+            j ^= bit;
+
+            if (i < j)
+            {
+                std::swap(re[i], re[j]);
+                std::swap(im[i], im[j]);
+            }
+        }
+
+        for (int length = 2; length <= size; length <<= 1)
+        {
+            const int half = length / 2, stride = size / length;
+
+            for (int start = 0; start < size; start += length)
+            {
+                for (int k = 0; k < half; ++k)
+                {
+                    const double wr = twiddleCos[k * stride], wi = -twiddleSin[k * stride];
+                    const int a = start + k, b = a + half;
+                    const double tr = re[b] * wr - im[b] * wi;
+                    const double ti = re[b] * wi + im[b] * wr;
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+        }
+    }
+}
+//==============================================================================
+GridRenderer::GridRenderer(const Options& renderOptions)
+    : options(renderOptions),
+      numSamples(jmax(1, (int) (renderOptions.seconds * renderOptions.sampleRate))),
+      pool(renderOptions.numThreads < 0 ? -1 : jmax(0, renderOptions.numThreads - 1))
+{
+    BlockNoise source((uint64) options.seed);
+    noise.allocate(numSamples, false);
+    source.fill(noise, numSamples);
+
+    window.allocate(fftSize, false);
+    for (int i = 0; i < fftSize; ++i)
+        window[i] = .5 - .5 * std::cos(2 * double_Pi * i / fftSize);
+
+    twiddleCos.allocate(fftSize / 2, false);
+    twiddleSin.allocate(fftSize / 2, false);
+    for (int i = 0; i < fftSize / 2; ++i)
+    {
+        twiddleCos[i] = std::cos(2 * double_Pi * i / fftSize);
+        twiddleSin[i] = std::sin(2 * double_Pi * i / fftSize);
+    }
+
+    if (options.wavDirectory != File())
+        options.wavDirectory.createDirectory();
+}
+//==============================================================================
+Array<GridRenderer::Point> GridRenderer::makeGrid(const Array<double>& cutoffs, const Array<double>& resonances,
+                                                  const Array<double>& drives, const Array<double>& modRates)
+{
+    Array<Point> points;
+    points.ensureStorageAllocated(cutoffs.size() * resonances.size() * drives.size() * modRates.size());
+
+    for (double cutoff : cutoffs)
+        for (int resonance = 0; resonance < resonances.size(); ++resonance)
+            for (double drive : drives)
+                for (double modRate : modRates)
+                {
+                    if (modRate > 0 && resonance > 0)
+                        continue;
+
+                    Point point;
+                    point.cutoff = cutoff;
+                    point.resonance = modRate > 0 ? std::numeric_limits<double>::quiet_NaN()
+                                                  : resonances[resonance];
+                    point.drive = drive;
+                    point.modRate = modRate;
+                    points.add(point);
+                }
+
+    return points;
+}
+
+Array<GridRenderer::Features> GridRenderer::render(const Array<Point>& points)
+{
+    Array<Features> features;
+    features.resize(points.size());
+
+    RenderContext context { this, points.begin(), features.begin() };
+    pool.run(renderPointJob, &context, points.size());
+    return features;
+}
+//==============================================================================
+String GridRenderer::formatSummary(const Array<Point>& points, const Array<Features>& features)
+{
+    String summary("index,cutoff,resonance,drive,modRate,rms,peak,centroidHz\n");
+
+    for (int i = 0; i < points.size(); ++i)
+    {
+        const Point& point = points.getReference(i);
+        const Features& feature = features.getReference(i);
+        const String resonance = point.modRate > 0 ? String() : String(point.resonance, 4);
+        summary << i << "," << String(point.cutoff, 4) << "," << resonance << ","
+                << String(point.drive, 4) << "," << String(point.modRate, 4) << ","
+                << String(feature.rms, 6) << "," << String(feature.peak, 6) << ","
+                << String(feature.centroidHz, 1) << "\n";
+    }
+
+    return summary;
+}
+
+String GridRenderer::getWavFileName(int index)
+{
+    return "point_" + String(index).paddedLeft('0', 5) + ".wav";
+}
+//==============================================================================
+void GridRenderer::renderPointJob(void* context, int jobIndex)
+{
+    const ScopedFlushDenormals flushDenormals;
+    const RenderContext& job = *static_cast<RenderContext*>(context);
+    job.features[jobIndex] = job.renderer->renderPoint(job.points[jobIndex], jobIndex);
+}
+
+GridRenderer::Features GridRenderer::renderPoint(const Point& point, int index) const
+{
+    JoeyNonLinearMoogSC filter(options.sampleRate);
+    filter.setSaturation(options.saturation);
+    filter.setSolver(options.solver);
+
+    BlockLFO lfo(options.sampleRate);
+    lfo.setFrequency(point.modRate);
+    const bool modulated = point.modRate > 0;
+
+    HeapBlock<float> output(numSamples);
+    float input[renderBlockSize], resonance[renderBlockSize], cutoff[renderBlockSize];
+    FloatVectorOperations::fill(cutoff, (float) point.cutoff, renderBlockSize);
+
+    for (int start = 0; start < numSamples; start += renderBlockSize)
+    {
+        const int blockSize = jmin(renderBlockSize, numSamples - start);
+        FloatVectorOperations::copyWithMultiply(input, noise + start, (float) point.drive, blockSize);
+
+        if (modulated)
+        {
+            // the LFO swings [-1, 1], resonance wants [0, 1], as in AudioProcessing
+            lfo.process(resonance, blockSize);
+            FloatVectorOperations::add(resonance, 1.0f, blockSize);
+            FloatVectorOperations::multiply(resonance, .5f, blockSize);
+            filter.processBlock(input, output + start, blockSize, resonance, cutoff);
+        }
+        else
+        {
+            filter.processBlock(input, output + start, blockSize, point.resonance, point.cutoff);
+        }
+    }
+
+    //==========================================================================
+    Features features;
+    double sumOfSquares = 0;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        sumOfSquares += output[i] * (double) output[i];
+        features.peak = jmax(features.peak, (double) std::abs(output[i]));
+    }
+
+    features.rms = std::sqrt(sumOfSquares / numSamples);
+    features.centroidHz = measureCentroid(output);
+
+    if (options.wavDirectory != File())
+        features.written = writeWavFile(output, index);
+
+    return features;
+}
+
+double GridRenderer::measureCentroid(const float* samples) const
+{
+    HeapBlock<double> re(fftSize), im(fftSize), power(fftSize / 2 + 1, true);
+    const int hop = fftSize / 2;
+
+    // a render shorter than a frame is zero padded into one
+    for (int start = 0; start == 0 || start + fftSize <= numSamples; start += hop)
+    {
+        for (int i = 0; i < fftSize; ++i)
+        {
+            re[i] = start + i < numSamples ? window[i] * samples[start + i] : 0;
+            im[i] = 0;
+        }
+
+        fft(re, im, fftSize, twiddleCos, twiddleSin);
+
+        for (int k = 0; k <= fftSize / 2; ++k)
+            power[k] += re[k] * re[k] + im[k] * im[k];
+    }
+
+    double weighted = 0, total = 0;
+    for (int k = 0; k <= fftSize / 2; ++k)
+    {
+        weighted += k * power[k];
+        total += power[k];
+    }
+
+    return total > 0 ? weighted / total * options.sampleRate / fftSize : 0;
+}
+
+bool GridRenderer::writeWavFile(const float* samples, int index) const
+{
+    const File file = options.wavDirectory.getChildFile(getWavFileName(index));
+    file.deleteFile();
+
+    ScopedPointer<FileOutputStream> stream(new FileOutputStream(file));
+    if (stream->failedToOpen())
+        return false;
+
+    WavAudioFormat wavFormat;
+    ScopedPointer<AudioFormatWriter> writer(wavFormat.createWriterFor(stream, options.sampleRate, 1,
+                                                                      24, StringPairArray(), 0));
+    if (writer == nullptr)
+        return false;
+
+    stream.release(); // the writer owns the stream now
+    return writer->writeFromFloatArrays(&samples, 1, numSamples);
+}
@@ -0,0 +1,153 @@
+//
+//  GridRenderer.hpp
+//
+//  Offline batch renderer for preset design and regression checks: runs a
+//  grid of cutoff, resonance, drive and resonance LFO rate settings through
+//  the nonlinear ladder on every core, and summarises each point.
+//
+
+#ifndef GridRenderer_hpp
+#define GridRenderer_hpp
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../joeyMoogClasses/NonLinearJoeyMoogSC.hpp"
+#include "ChainWorkerPool.hpp"
+
+/**
+ GridRenderer class: renders every point of a parameter grid through its own
+ JoeyNonLinearMoogSC, one ChainWorkerPool job per point.
+
+ Every point filters the same seeded white noise, scaled by its drive, at a
+ fixed cutoff. Its resonance is either fixed too or, as AudioProcessing
+ plays it, driven by a sine BlockLFO mapped from [-1, 1] to [0, 1], so a
+ point can reproduce what the app sounds like. Each job builds a fresh
+ filter, LFO and buffers and writes only its own features and wav file; the
+ noise, window and FFT tables it reads are made once by the constructor. So
+ a point's result depends only on the point and the options, and the same
+ grid gives the same summary and files on any number of threads, while the
+ jobs share nothing that would stop them scaling with the cores.
+
+ The features are the RMS and peak of the whole render and its spectral
+ centroid: the power weighted mean frequency of Hann windowed frames of
+ fftSize samples, overlapping by half, with their power spectra summed.
+ */
+class GridRenderer
+{
+public:
+    //==============================================================================
+    /** one setting of the filter */
+    struct Point
+    {
+        /** cutoff side chain, 0 to 1 */
+        double cutoff = .5;
+        /** resonance side chain, 0 to 1, while modRate is 0. Ignored otherwise,
+            and NaN in the modulated points of makeGrid() */
+        double resonance = .5;
+        /** gain on the noise, which spans [-0.5, 0.5) */
+        double drive = 1;
+        /** rate in Hz of the LFO sweeping resonance over [0, 1], as the app's
+            lfo rate, or 0 for the fixed resonance */
+        double modRate = 0;
+    };
+
+    /** summary of one rendered point */
+    struct Features
+    {
+        double rms = 0, peak = 0;
+        /** power weighted mean frequency in Hz, 0 for silence */
+        double centroidHz = 0;
+        /** false if the point's wav file was asked for and could not be written */
+        bool written = true;
+    };
+
+    /** what every point is rendered with */
+    struct Options
+    {
+        double sampleRate = 48000;
+        double seconds = 1;
+        /** seed of the noise every point filters */
+        int64 seed = 1;
+        LadderSaturation saturation = LadderSaturation::JOEY_MOOG_SATURATION;
+        LadderSolver solver = LadderSolver::JOEY_MOOG_SOLVER;
+        /** directory to write point_<index>.wav files into, or File() for the
+            features only */
+        File wavDirectory;
+        /** threads to render on, counting the caller, or -1 for one per core */
+        int numThreads = -1;
+    };
+
+    /** samples per spectrum frame */
+    static const int fftSize = 2048;
+    //==============================================================================
+    /**
+     makes the noise and spectrum tables and starts the pool's threads
+
+     @param options what every point is rendered with
+     */
+    GridRenderer(const Options& options);
+    //==============================================================================
+    /**
+     @returns every combination of the axis values, cutoff varying slowest and
+              modulation rate fastest. The LFO sets a modulated point's
+              resonance, so those are made once rather than once per
+              resonance, with a NaN resonance
+     */
+    static Array<Point> makeGrid(const Array<double>& cutoffs, const Array<double>& resonances,
+                                 const Array<double>& drives, const Array<double>& modRates);
+
+    /**
+     renders every point on the pool and waits for them all
+
+     @param points settings to render
+     @returns the features of each point, in the order of points
+     */
+    Array<Features> render(const Array<Point>& points);
+
+    /** @returns the threads the points are rendered on, counting the caller */
+    int getNumThreads() const { return pool.getNumWorkers() + 1; }
+
+    /** @returns the samples rendered for each point */
+    int getNumSamples() const { return numSamples; }
+    //==============================================================================
+    /**
+     @returns a CSV table with a header line, then a line per point with its
+              index, settings and features. The resonance field is left
+              empty for points whose resonance the LFO sweeps
+     */
+    static String formatSummary(const Array<Point>& points, const Array<Features>& features);
+
+    /** @returns the name of the wav file of the point with the given index */
+    static String getWavFileName(int index);
+
+private:
+    //==============================================================================
+    /** what a render() passes to each job */
+    struct RenderContext
+    {
+        const GridRenderer* renderer;
+        const Point* points;
+        Features* features;
+    };
+
+    static void renderPointJob(void* context, int jobIndex);
+    /** renders a point on a filter of its own and summarises it */
+    Features renderPoint(const Point& point, int index) const;
+    /** @returns the spectral centroid of samples, in Hz */
+    double measureCentroid(const float* samples) const;
+    /** @returns false if the point's wav file could not be written */
+    bool writeWavFile(const float* samples, int index) const;
+    //==============================================================================
+    const Options options;
+    const int numSamples;
+
+    /** the noise every point filters, before the drive */
+    HeapBlock<float> noise;
+    /** Hann window, and cos and sin of the FFT's twiddle angles */
+    HeapBlock<double> window, twiddleCos, twiddleSin;
+
+    ChainWorkerPool pool;
+
+    JUCE_DECLARE_NON_COPYABLE(GridRenderer)
+};
+
+#endif /* GridRenderer_hpp */
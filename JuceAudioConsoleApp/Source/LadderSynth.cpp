@@ -0,0 +1,343 @@
+//
+//  LadderSynth.cpp
+//
+
+#include "LadderSynth.hpp"
+
+namespace
+{
+    /** envelope times in seconds and sustain level */
+    const double attackTime = .005, decayTime = .2, releaseTime = .3;
+    const float sustainLevel = .6f;
+    /** level of a full velocity voice into its ladder */
+    const float voiceGain = .4f;
+    /** ladder state level below which a released voice's tail is over, about
+        -80 dB, and how long a tail that does not die away, such as a self
+        oscillating ladder's, rings before a fade of ringFadeTime seconds */
+    const double silenceLevel = 1.0e-4, maxRingTime = .5, ringFadeTime = .02;
+
+    /** PolyBLEP correction for the saw's jump at phase 0 */
+    inline double polyBlep(double phase, double increment)
+    {
+        if (phase < increment)
+        {
+            const double t = phase / increment;
+            return t + t - t * t - 1;
+        }
+        if (phase > 1 - increment)
+        {
+            const double t = (phase - 1) / increment;
+            return t * t + t + t + 1;
+        }
+        return 0;
+    }
+}
+//==============================================================================
+LadderSynth::LadderSynth(int numVoices)
+{
+    for (int i = 0; i < jmax(1, numVoices); ++i)
+        voices.add(new Voice());
+
+    incoming.allocate(fifo.getTotalSize(), true);
+    blockEvents.allocate(fifo.getTotalSize(), true);
+}
+
+LadderSynth::~LadderSynth()
+{
+}
+//==============================================================================
+void LadderSynth::prepare(double newSampleRate, int maxBlockSize)
+{
+    sampleRate = newSampleRate;
+    activeVoices.allocate(voices.size(), true);
+
+    for (Voice* voice : voices)
+        voice->prepare(sampleRate, jmax(1, maxBlockSize));
+}
+
+void LadderSynth::handleIncomingMidiMessage(MidiInput*, const MidiMessage& message)
+{
+    Event event { message.getTimeStamp(), Event::noteOn, 0, 0 };
+
+    if (message.isNoteOn())
+    {
+        event.note = message.getNoteNumber();
+        event.velocity = message.getFloatVelocity();
+    }
+    else if (message.isNoteOff())
+    {
+        event.type = Event::noteOff;
+        event.note = message.getNoteNumber();
+    }
+    else if (message.isAllNotesOff() || message.isAllSoundOff())
+    {
+        event.type = Event::allNotesOff;
+    }
+    else
+    {
+        return;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 + size2 > 0)
+    {
+        incoming[size1 > 0 ? start1 : start2] = event;
+        fifo.finishedWrite(1);
+    }
+}
+//==============================================================================
+void LadderSynth::beginCallback(int numSamples) noexcept
+{
+    // the callback plays the last numSamples worth of time, so an event is
+    // placed as far into it as it came after that time began
+    const double blockStart = Time::getMillisecondCounterHiRes() * .001 - numSamples / sampleRate;
+
+    // anything the last callback did not render up to still has to happen
+    while (nextBlockEvent < numBlockEvents)
+        handleEvent(blockEvents[nextBlockEvent++]);
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(fifo.getNumReady(), start1, size1, start2, size2);
+
+    numBlockEvents = size1 + size2;
+    nextBlockEvent = 0;
+
+    for (int i = 0; i < numBlockEvents; ++i)
+    {
+        Event event = incoming[i < size1 ? start1 + i : start2 + i - size1];
+        event.time = jlimit(0, jmax(0, numSamples - 1), roundToInt((event.time - blockStart) * sampleRate));
+        blockEvents[i] = event;
+    }
+
+    fifo.finishedRead(numBlockEvents);
+
+    // timestamps from different inputs can arrive out of order. An insertion
+    // sort keeps equal times in arrival order without std::stable_sort's buffer
+    for (int i = 1; i < numBlockEvents; ++i)
+    {
+        const Event event = blockEvents[i];
+        int j = i;
+        for (; j > 0 && blockEvents[j - 1].time > event.time; --j)
+            blockEvents[j] = blockEvents[j - 1];
+        blockEvents[j] = event;
+    }
+}
+
+void LadderSynth::skip(int startSample, int numSamples) noexcept
+{
+    while (nextBlockEvent < numBlockEvents && (int) blockEvents[nextBlockEvent].time < startSample + numSamples)
+        ++nextBlockEvent;
+}
+
+void LadderSynth::reset() noexcept
+{
+    for (Voice* voice : voices)
+        voice->stop();
+}
+
+void LadderSynth::render(float* output, int startSample, int numSamples, double cutoff, double resonance) noexcept
+{
+    const int endSample = startSample + numSamples;
+    int position = startSample;
+
+    while (position < endSample)
+    {
+        // run up to the next event in this part of the callback, then apply it
+        int splitSample = endSample;
+        if (nextBlockEvent < numBlockEvents)
+            splitSample = jmax(position, jmin(endSample, (int) blockEvents[nextBlockEvent].time));
+
+        if (splitSample > position)
+        {
+            const int numSamplesToRender = splitSample - position;
+            int numActive = 0;
+            for (Voice* voice : voices)
+                if (voice->isActive())
+                    activeVoices[numActive++] = voice;
+
+            VoiceJobContext context { this, numSamplesToRender, cutoff, resonance };
+            if (workerPool != nullptr)
+                workerPool->run(renderVoiceJob, &context, numActive);
+            else
+                for (int i = 0; i < numActive; ++i)
+                    renderVoiceJob(&context, i);
+
+            for (int i = 0; i < numActive; ++i)
+                FloatVectorOperations::add(output + position - startSample, activeVoices[i]->getBuffer(),
+                                           numSamplesToRender);
+            position = splitSample;
+        }
+
+        while (nextBlockEvent < numBlockEvents && (int) blockEvents[nextBlockEvent].time <= position
+               && position < endSample)
+            handleEvent(blockEvents[nextBlockEvent++]);
+    }
+}
+
+void LadderSynth::renderVoiceJob(void* context, int jobIndex)
+{
+    const ScopedFlushDenormals flushDenormals;
+    const VoiceJobContext& job = *static_cast<VoiceJobContext*>(context);
+    job.synth->activeVoices[jobIndex]->render(job.numSamples, job.cutoff, job.resonance);
+}
+
+int LadderSynth::getNumActiveVoices() const noexcept
+{
+    int numActive = 0;
+    for (const Voice* voice : voices)
+        numActive += voice->isActive() ? 1 : 0;
+    return numActive;
+}
+//==============================================================================
+void LadderSynth::handleEvent(const Event& event) noexcept
+{
+    switch (event.type)
+    {
+        case Event::noteOn:
+            findVoiceToStart(event.note).start(event.note, event.velocity, ++noteOnCount);
+            break;
+
+        case Event::noteOff:
+            for (Voice* voice : voices)
+                if (voice->isActive() && ! voice->isReleasing() && voice->getNote() == event.note)
+                    voice->release();
+            break;
+
+        case Event::allNotesOff:
+            for (Voice* voice : voices)
+                if (voice->isActive())
+                    voice->release();
+            break;
+    }
+}
+
+LadderSynth::Voice& LadderSynth::findVoiceToStart(int note) noexcept
+{
+    Voice* quietestReleasing = nullptr;
+    Voice* oldest = nullptr;
+
+    for (Voice* voice : voices)
+    {
+        // the same note retriggers its own voice rather than stacking
+        if (! voice->isActive() || voice->getNote() == note)
+            return *voice;
+
+        if (voice->isReleasing() && (quietestReleasing == nullptr || voice->getLevel() < quietestReleasing->getLevel()))
+            quietestReleasing = voice;
+
+        if (oldest == nullptr || voice->getOrder() < oldest->getOrder())
+            oldest = voice;
+    }
+
+    return quietestReleasing != nullptr ? *quietestReleasing : *oldest;
+}
+//==============================================================================
+void LadderSynth::Voice::prepare(double newSampleRate, int maxBlockSize)
+{
+    sampleRate = newSampleRate;
+    buffer.allocate(maxBlockSize, true);
+    filter.init(sampleRate);
+    filter.setSaturation(LadderSaturation::rational);
+
+    attackStep = (float) (1 / (attackTime * sampleRate));
+    decayStep = (float) ((1 - sustainLevel) / (decayTime * sampleRate));
+    releaseStep = (float) (1 / (releaseTime * sampleRate));
+    maxRingSamples = (int) (maxRingTime * sampleRate);
+    ringFadeStep = (float) (1 / (ringFadeTime * sampleRate));
+
+    stage = idle;
+    level = 0;
+}
+
+void LadderSynth::Voice::start(int newNote, float velocity, uint32 newOrder)
+{
+    // a stolen or retriggered voice attacks from where its envelope is, so
+    // there is no jump in level. A voice that has gone quiet, or is fading
+    // its tail out, starts its ladder from silence rather than from the state
+    // the last note left in it
+    if (stage == idle || ringGain < 1)
+        filter.reset();
+
+    ringGain = 1;
+    note = newNote;
+    order = newOrder;
+    gain = voiceGain * velocity;
+    phaseIncrement = MidiMessage::getMidiNoteInHertz(note) / sampleRate;
+    stage = attacking;
+}
+
+void LadderSynth::Voice::release()
+{
+    stage = releasing;
+}
+
+void LadderSynth::Voice::render(int numSamples, double cutoff, double resonance)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        switch (stage)
+        {
+            case attacking:
+                level += attackStep;
+                if (level >= 1)
+                {
+                    level = 1;
+                    stage = decaying;
+                }
+                break;
+
+            case decaying:
+                level -= decayStep;
+                if (level <= sustainLevel)
+                {
+                    level = sustainLevel;
+                    stage = sustaining;
+                }
+                break;
+
+            case releasing:
+                level -= releaseStep;
+                if (level <= 0)
+                {
+                    level = 0;
+                    stage = ringing;
+                    ringSamplesLeft = maxRingSamples;
+                    ringGain = 1;
+                }
+                break;
+
+            case ringing:
+            case sustaining:
+            case idle:
+                break;
+        }
+
+        const double saw = 2 * phase - 1 - polyBlep(phase, phaseIncrement);
+        phase += phaseIncrement;
+        if (phase >= 1)
+            phase -= 1;
+
+        buffer[i] = (float) saw * level * gain;
+    }
+
+    // the cutoff side chain spans ten octaves, so this moves it an octave per octave
+    const double keyTrackedCutoff = jlimit(0.0, 1.0, cutoff + (note - 60) / 120.0);
+    filter.processBlock(buffer, buffer, numSamples, resonance, keyTrackedCutoff);
+
+    if (stage == ringing)
+    {
+        const int numUnfaded = jmin(numSamples, ringSamplesLeft);
+        ringSamplesLeft -= numUnfaded;
+
+        for (int i = numUnfaded; i < numSamples; ++i)
+        {
+            ringGain = jmax(0.0f, ringGain - ringFadeStep);
+            buffer[i] *= ringGain;
+        }
+
+        if (ringGain <= 0 || filter.getStatePeak() < silenceLevel)
+            stage = idle;
+    }
+}
@@ -0,0 +1,190 @@
+//
+//  LadderSynth.hpp
+//
+//  Polyphonic MIDI synth: a fixed pool of voices, each a saw oscillator and
+//  an envelope into its own nonlinear Moog ladder.
+//
+
+#ifndef LadderSynth_hpp
+#define LadderSynth_hpp
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../joeyMoogClasses/NonLinearJoeyMoogSC.hpp"
+#include "ChainWorkerPool.hpp"
+
+/**
+ LadderSynth class: receives MIDI on the MIDI thread and plays it on the audio
+ thread.
+
+ handleIncomingMidiMessage() turns each note message into a small event and
+ pushes it into an AbstractFifo. AudioDeviceManager delivers every input's
+ messages under one lock, so the fifo has a single producer.
+ beginCallback() moves the waiting events into the block, placing each at
+ the sample its timestamp falls on in the last block's worth of time.
+ render() then splits the block at those samples, so notes start and stop
+ sample accurately.
+
+ Every voice and buffer is allocated by prepare(), and the audio thread
+ never allocates. Voices that are not sounding are skipped entirely; a
+ released voice counts as sounding until its ladder's tail has died away.
+ Given a ChainWorkerPool, the sounding voices render on every core, each into
+ its own buffer, and are then summed on the audio thread.
+ */
+class LadderSynth : public MidiInputCallback
+{
+public:
+    //==============================================================================
+    /** @param numVoices size of the voice pool */
+    LadderSynth(int numVoices = 16);
+    ~LadderSynth();
+    //==============================================================================
+    /**
+     allocates the voices and buffers. Not real time safe.
+
+     @param sampleRate sample rate to run at
+     @param maxBlockSize largest numSamples render() will be given
+     */
+    void prepare(double sampleRate, int maxBlockSize);
+
+    /** queues a note event. Wait-free, called on the MIDI thread */
+    void handleIncomingMidiMessage(MidiInput* source, const MidiMessage& message) override;
+    //==============================================================================
+    /**
+     takes the queued events for the next callback. Audio thread only.
+
+     @param numSamples length of the whole callback
+     */
+    void beginCallback(int numSamples) noexcept;
+
+    /**
+     drops the events that fall in part of the callback, in place of render()
+     while the synth is not being played. Audio thread only.
+
+     @param startSample position of the part in the callback
+     @param numSamples number of samples
+     */
+    void skip(int startSample, int numSamples) noexcept;
+
+    /** silences every voice at once, e.g. before render() resumes after skip().
+        Audio thread only. */
+    void reset() noexcept;
+
+    /**
+     adds the voices to part of the callback, applying the events that fall in it
+
+     @param output buffer to add to
+     @param startSample position of output in the callback
+     @param numSamples number of samples, no more than maxBlockSize
+     @param cutoff ladder cutoff at middle C, keytracked for other notes
+     @param resonance ladder resonance
+     */
+    void render(float* output, int startSample, int numSamples, double cutoff, double resonance) noexcept;
+
+    /** @returns the number of voices sounding. Audio thread only */
+    int getNumActiveVoices() const noexcept;
+
+    /**
+     renders the voices on a worker pool. Set before the callbacks start.
+
+     @param pool pool to use, or nullptr to render on the audio thread alone
+     */
+    void setWorkerPool(ChainWorkerPool* pool) { workerPool = pool; }
+
+private:
+    //==============================================================================
+    /** a note event, compact enough to pass through the fifo */
+    struct Event
+    {
+        enum Type { noteOn, noteOff, allNotesOff };
+
+        /** seconds on the Time::getMillisecondCounterHiRes() clock, or a sample
+            offset in the callback once taken off the fifo */
+        double time;
+        Type type;
+        int note;
+        float velocity;
+    };
+    //==============================================================================
+    /**
+     one voice: a PolyBLEP saw into a linear ADSR into a nonlinear ladder
+     */
+    class Voice
+    {
+    public:
+        Voice(){};
+        ~Voice(){};
+
+        /** @param maxBlockSize largest numSamples render() will be given */
+        void prepare(double sampleRate, int maxBlockSize);
+        /** starts a note, from the current envelope level if stolen */
+        void start(int note, float velocity, uint32 order);
+        /** moves the envelope into its release */
+        void release();
+        /** stops the voice at once, without a tail */
+        void stop() { stage = idle; }
+        /** renders numSamples of the voice into getBuffer() */
+        void render(int numSamples, double cutoff, double resonance);
+
+        const float* getBuffer() const { return buffer; }
+
+        bool isActive() const { return stage != idle; }
+        bool isReleasing() const { return stage == releasing || stage == ringing; }
+        int getNote() const { return note; }
+        float getLevel() const { return level; }
+        uint32 getOrder() const { return order; }
+
+    private:
+        /** ringing runs the ladder on after the envelope has closed, until
+            its tail dies away or is faded out */
+        enum Stage { idle, attacking, decaying, sustaining, releasing, ringing };
+
+        JoeyNonLinearMoogSC filter;
+        HeapBlock<float> buffer;
+        double sampleRate = 44100;
+        /** saw phase in [0, 1) and increment per sample */
+        double phase = 0, phaseIncrement = 0;
+        /** envelope level and its step per sample in the current stage */
+        float level = 0, attackStep = 0, decayStep = 0, releaseStep = 0;
+        float gain = 0;
+        /** samples the tail may ring for before it is faded, and its fade gain and step */
+        int ringSamplesLeft = 0, maxRingSamples = 0;
+        float ringGain = 1, ringFadeStep = 0;
+        Stage stage = idle;
+        int note = -1;
+        /** note on count when started, lower is older */
+        uint32 order = 0;
+    };
+    //==============================================================================
+    /** applies one event to the voice pool */
+    void handleEvent(const Event& event) noexcept;
+    /** @returns the voice a new note should take: idle, else the quietest
+        releasing one, else the oldest */
+    Voice& findVoiceToStart(int note) noexcept;
+
+    /** what renderVoiceJob() needs from render() */
+    struct VoiceJobContext
+    {
+        LadderSynth* synth;
+        int numSamples;
+        double cutoff, resonance;
+    };
+
+    /** ChainWorkerPool job: renders sounding voice jobIndex */
+    static void renderVoiceJob(void* context, int jobIndex);
+    //==============================================================================
+    OwnedArray<Voice> voices;
+    AbstractFifo fifo {512};
+    HeapBlock<Event> incoming;
+    /** events taken by beginCallback(), in sample order */
+    HeapBlock<Event> blockEvents;
+    int numBlockEvents = 0, nextBlockEvent = 0;
+    /** the voices sounding in the part of the block being rendered */
+    HeapBlock<Voice*> activeVoices;
+    ChainWorkerPool* workerPool = nullptr;
+    double sampleRate = 44100;
+    uint32 noteOnCount = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(LadderSynth)
+};
+
+#endif /* LadderSynth_hpp */
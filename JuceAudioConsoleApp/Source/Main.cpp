@@ -10,16 +10,371 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "AudioProcessing.hpp"
+#include "GridRenderer.hpp"
 //#include <wiringPi.h>
 //==============================================================================
+/**
+ @returns the argument after flag, or fallback if flag was not given
+ */
+static String getArgument (const StringArray& args, const String& flag, const String& fallback)
+{
+    const int index = args.indexOf (flag);
+    return (index >= 0 && index + 1 < args.size()) ? args[index + 1] : fallback;
+}
+
+/**
+ Runs the AudioProcessing DSP chain as fast as it will go, without an audio
+ device, and writes the result to a wav file.
+ 
+ usage: --render out.wav [--seconds N] [--rate R] [--block B] [--seed S]
+ 
+ The same seed and sample rate always render the same file, whatever the
+ block size.
+ 
+ @returns the exit code for main()
+ */
+static int renderOffline (const StringArray& args)
+{
+    const File outputFile = File::getCurrentWorkingDirectory().getChildFile (getArgument (args, "--render", "render.wav"));
+    const double seconds    = getArgument (args, "--seconds", "10").getDoubleValue();
+    const double sampleRate = getArgument (args, "--rate", "48000").getDoubleValue();
+    const int blockSize     = getArgument (args, "--block", "256").getIntValue();
+    const int64 seed        = getArgument (args, "--seed", "1").getLargeIntValue();
+    const int numChannels   = 2;
+    
+    if (seconds <= 0 || sampleRate <= 0 || blockSize <= 0)
+    {
+        printf ("usage: --render out.wav [--seconds N] [--rate R] [--block B] [--seed S]\n");
+        return 1;
+    }
+    
+    //==========================================================================
+    outputFile.deleteFile();
+    ScopedPointer<FileOutputStream> stream (new FileOutputStream (outputFile));
+    
+    if (stream->failedToOpen())
+    {
+        printf ("could not open %s\n", outputFile.getFullPathName().toRawUTF8());
+        return 1;
+    }
+    
+    WavAudioFormat wavFormat;
+    ScopedPointer<AudioFormatWriter> writer (wavFormat.createWriterFor (stream, sampleRate, numChannels,
+                                                                         24, StringPairArray(), 0));
+    if (writer == nullptr)
+    {
+        printf ("could not write a %.0f Hz wav file\n", sampleRate);
+        return 1;
+    }
+    
+    stream.release(); // the writer owns the stream now
+    
+    //==========================================================================
+    AudioProcessing processor (false);
+    processor.setNoiseSeed (seed);
+    processor.prepareToPlay (sampleRate, blockSize);
+    
+    AudioBuffer<float> buffer (numChannels, blockSize);
+    const int64 totalSamples = (int64) (seconds * sampleRate);
+    int64 processTicks = 0;
+    const int64 renderStart = Time::getHighResolutionTicks();
+    
+    for (int64 done = 0; done < totalSamples; done += blockSize)
+    {
+        const int numSamples = (int) jmin ((int64) blockSize, totalSamples - done);
+        
+        const int64 blockStart = Time::getHighResolutionTicks();
+        processor.processBlock (buffer.getArrayOfWritePointers(), numChannels, numSamples);
+        processTicks += Time::getHighResolutionTicks() - blockStart;
+        
+        writer->writeFromAudioSampleBuffer (buffer, 0, numSamples);
+    }
+    
+    writer = nullptr; // flushes and closes the file
+    
+    //==========================================================================
+    const double renderedSeconds = totalSamples / sampleRate;
+    const double processSeconds = Time::highResolutionTicksToSeconds (processTicks);
+    const double totalSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - renderStart);
+    
+    printf ("rendered %.2f s at %.0f Hz in blocks of %d to %s\n",
+            renderedSeconds, sampleRate, blockSize, outputFile.getFullPathName().toRawUTF8());
+    printf ("realtime factor %.1fx processing only (%.3f s), %.1fx with the file write (%.3f s)\n",
+            renderedSeconds / jmax (processSeconds, 1.0e-9), processSeconds,
+            renderedSeconds / jmax (totalSeconds, 1.0e-9), totalSeconds);
+    return 0;
+}
+//==============================================================================
+/**
+ reads a grid axis from the command line, either a comma separated list of
+ values or start:end:count for count values evenly spaced from start to end
+
+ @returns the values after flag, or those of fallback if flag was not given
+ */
+static Array<double> getAxis (const StringArray& args, const String& flag, const String& fallback)
+{
+    const String text = getArgument (args, flag, fallback);
+    Array<double> values;
+    
+    if (text.containsChar (':'))
+    {
+        const StringArray range = StringArray::fromTokens (text, ":", String());
+        const double start = range[0].getDoubleValue(), end = range[1].getDoubleValue();
+        const int count = range[2].getIntValue();
+        
+        for (int i = 0; i < count; ++i)
+            values.add (count > 1 ? start + (end - start) * i / (count - 1) : start);
+    }
+    else
+    {
+        for (const String& value : StringArray::fromTokens (text, ",", String()))
+            if (value.trim().isNotEmpty())
+                values.add (value.getDoubleValue());
+    }
+    
+    return values;
+}
+
+/**
+ Renders every combination of the given cutoffs, resonances, drives and
+ resonance LFO rates through the nonlinear ladder, one point per job on all
+ the cores, and writes a CSV summary of each point's RMS, peak and spectral
+ centroid, plus a wav file per point with --wav-dir. A mod rate above 0
+ sweeps resonance as the app's LFO does, in place of the resonances, and
+ leaves that point's resonance field in the CSV empty.
+ 
+ usage: --render-grid summary.csv [--cutoffs LIST] [--resonances LIST]
+        [--drives LIST] [--mod-rates LIST] [--wav-dir DIR]
+        [--seconds N] [--rate R] [--seed S] [--threads N]
+        [--solver linearised|draft|standard|precise]
+        [--saturation exact|rational|table]
+ 
+ A LIST is comma separated values or start:end:count. The same arguments
+ always give the same summary and files, whatever the thread count.
+ 
+ @returns the exit code for main()
+ */
+static int renderGrid (const StringArray& args)
+{
+    const File workingDirectory = File::getCurrentWorkingDirectory();
+    const File summaryFile = workingDirectory.getChildFile (getArgument (args, "--render-grid", "grid.csv"));
+    const String wavDirectory = getArgument (args, "--wav-dir", String());
+    const String solver = getArgument (args, "--solver", String());
+    const String saturation = getArgument (args, "--saturation", String());
+    
+    GridRenderer::Options options;
+    options.seconds    = getArgument (args, "--seconds", "1").getDoubleValue();
+    options.sampleRate = getArgument (args, "--rate", "48000").getDoubleValue();
+    options.seed       = getArgument (args, "--seed", "1").getLargeIntValue();
+    options.numThreads = getArgument (args, "--threads", "-1").getIntValue();
+    
+    if (wavDirectory.isNotEmpty())
+        options.wavDirectory = workingDirectory.getChildFile (wavDirectory);
+    
+    if (solver == "linearised")     options.solver = LadderSolver::linearised;
+    else if (solver == "draft")     options.solver = LadderSolver::implicitDraft;
+    else if (solver == "standard")  options.solver = LadderSolver::implicitStandard;
+    else if (solver == "precise")   options.solver = LadderSolver::implicitPrecise;
+    
+    if (saturation == "exact")          options.saturation = LadderSaturation::exact;
+    else if (saturation == "rational")  options.saturation = LadderSaturation::rational;
+    else if (saturation == "table")     options.saturation = LadderSaturation::table;
+    
+    const Array<GridRenderer::Point> points = GridRenderer::makeGrid (getAxis (args, "--cutoffs", "0.1:0.9:9"),
+                                                                      getAxis (args, "--resonances", "0:0.9:4"),
+                                                                      getAxis (args, "--drives", "0.5,1,2,4"),
+                                                                      getAxis (args, "--mod-rates", "0,0.5,4"));
+    
+    if (options.seconds <= 0 || options.sampleRate <= 0 || points.isEmpty())
+    {
+        printf ("usage: --render-grid summary.csv [--cutoffs LIST] [--resonances LIST] [--drives LIST]\n"
+                "       [--mod-rates LIST] [--wav-dir DIR] [--seconds N] [--rate R]\n"
+                "       [--seed S] [--threads N] [--solver linearised|draft|standard|precise]\n"
+                "       [--saturation exact|rational|table]\n"
+                "a LIST is comma separated values or start:end:count. A mod rate above 0 sweeps\n"
+                "resonance with the LFO, and those rows have an empty resonance field\n");
+        return 1;
+    }
+    
+    //==========================================================================
+    GridRenderer renderer (options);
+    const int64 renderStart = Time::getHighResolutionTicks();
+    const Array<GridRenderer::Features> features = renderer.render (points);
+    const double renderSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - renderStart);
+    
+    if (! summaryFile.replaceWithText (GridRenderer::formatSummary (points, features)))
+    {
+        printf ("could not write %s\n", summaryFile.getFullPathName().toRawUTF8());
+        return 1;
+    }
+    
+    int failedWrites = 0;
+    for (const GridRenderer::Features& feature : features)
+        failedWrites += feature.written ? 0 : 1;
+    
+    //==========================================================================
+    printf ("rendered %d points of %.2f s at %.0f Hz on %d threads to %s\n",
+            points.size(), renderer.getNumSamples() / options.sampleRate, options.sampleRate,
+            renderer.getNumThreads(), summaryFile.getFullPathName().toRawUTF8());
+    printf ("%.3f s, %.1f points/s, realtime factor %.1fx\n",
+            renderSeconds, points.size() / jmax (renderSeconds, 1.0e-9),
+            points.size() * renderer.getNumSamples() / options.sampleRate / jmax (renderSeconds, 1.0e-9));
+    
+    if (failedWrites > 0)
+    {
+        printf ("could not write %d wav files to %s\n", failedWrites,
+                options.wavDirectory.getFullPathName().toRawUTF8());
+        return 1;
+    }
+    
+    return 0;
+}
+//==============================================================================
+/**
+ reads the realtime mode from the command line: --rt turns it on, and
+ --rt-priority P and --rt-cpu C turn it on with a SCHED_FIFO priority or a
+ CPU to pin the audio thread to
+ */
+static RealtimeMode::Options getRealtimeOptions (const StringArray& args)
+{
+    RealtimeMode::Options options;
+    options.enabled  = args.contains ("--rt") || args.contains ("--rt-priority") || args.contains ("--rt-cpu");
+    options.priority = jlimit (1, 99, getArgument (args, "--rt-priority", String (options.priority)).getIntValue());
+    options.cpu      = getArgument (args, "--rt-cpu", "-1").getIntValue();
+    return options;
+}
+
+/**
+ reads the output device from the command line: --alsa-mmap PCM drives the
+ ALSA PCM through mmap, with [--period N] frames per period, [--periods N]
+ periods in the ring buffer and [--rate R]. --virtual-clock runs from a timer
+ instead of a sound card, with [--period N] and [--rate R] too and callbacks
+ woken up to [--jitter MS] late
+ */
+static AudioDeviceOptions getDeviceOptions (const StringArray& args)
+{
+    AudioDeviceOptions options;
+    options.mmapPcmName = getArgument (args, "--alsa-mmap", String());
+    options.virtualClock = args.contains ("--virtual-clock");
+    options.maxJitterMs = jmax (0.0, getArgument (args, "--jitter", "0").getDoubleValue());
+    options.sampleRate  = getArgument (args, "--rate", String (options.sampleRate)).getDoubleValue();
+    options.periodSize  = getArgument (args, "--period", String (options.periodSize)).getIntValue();
+    options.numPeriods  = getArgument (args, "--periods", String (options.numPeriods)).getIntValue();
+    return options;
+}
+
+/** prints what the realtime mode set up, once the audio thread has had its first callback */
+static void reportRealtimeMode (const RealtimeMode& realtimeMode)
+{
+    if (! realtimeMode.isEnabled())
+        return;
+    
+    for (int i = 0; i < 20 && ! realtimeMode.hasApplied(); ++i)
+        Thread::sleep (50);
+    
+    printf ("%s", realtimeMode.getReport().toRawUTF8());
+}
+//==============================================================================
+/** sets a parameter from the console and shows where it ended up */
+static void setParameter (ParameterStore& parameters, int index, float value)
+{
+    parameters.setValue (index, value);
+    printf ("%s %.3f\n", parameters.getName (index).toRawUTF8(), parameters.getValue (index));
+}
+//==============================================================================
 int main (int argc, char* argv[])
 {
-    AudioProcessing processor;
+    const StringArray args (argv + 1, argc - 1);
+    
+    if (args.indexOf ("--render") >= 0)
+        return renderOffline (args);
+    
+    if (args.indexOf ("--render-grid") >= 0)
+        return renderGrid (args);
+    
+    AudioProcessing processor (true, getRealtimeOptions (args), getDeviceOptions (args));
+    printf ("%s", processor.getDeviceReport().toRawUTF8());
+    reportRealtimeMode (processor.getRealtimeMode());
 //    wiringPiSetup () ;
 //    pinMode (0, OUTPUT) ;
     
-    while (getchar() != 'q')
+    // --run-for S runs unattended, e.g. under --virtual-clock in CI, and
+    // prints the reports once instead of reading keys
+    const double runSeconds = getArgument (args, "--run-for", "0").getDoubleValue();
+    
+    if (runSeconds > 0)
+    {
+        Thread::sleep ((int) (runSeconds * 1000));
+        printf ("device xruns %d\n", processor.getDeviceXRunCount());
+        printf ("%s", processor.getDeviceReport().toRawUTF8());
+        processor.getCallbackMonitor().requestReport (true);
+        
+        // the report is printed from the monitor's own thread
+        Thread::sleep (500);
+        return 0;
+    }
+    
+    ParameterStore& parameters = processor.getParameters();
+    
+    printf ("c/C: cutoff down/up, f/F: lfo rate down/up, g/G: noise gain down/up, i: toggle independent channels\n");
+    printf ("l: next lfo shape, n: next noise colour, m: toggle between the noise drone and the MIDI synth\n");
+    printf ("k/K: modulation control interval down/up (1 is every sample)\n");
+    printf ("s: callback stats, h: stats and load histogram, r: reset stats, q: quit\n");
+    
+    for (int key = getchar(); key != 'q'; key = getchar())
     {
+        if (key == 's' || key == 'h')
+        {
+            printf ("device xruns %d\n", processor.getDeviceXRunCount());
+            printf ("%s", processor.getDeviceReport().toRawUTF8());
+            printf ("%s", processor.getRealtimeMode().getReport().toRawUTF8());
+            processor.getCallbackMonitor().requestReport (key == 'h');
+        }
+        else if (key == 'r')
+        {
+            processor.getCallbackMonitor().requestReset();
+        }
+        else if (key == 'c' || key == 'C')
+        {
+            const int index = AudioProcessing::cutoffParameter;
+            setParameter (parameters, index, parameters.getValue (index) + (key == 'C' ? .05f : -.05f));
+        }
+        else if (key == 'f' || key == 'F')
+        {
+            const int index = AudioProcessing::lfoRateParameter;
+            setParameter (parameters, index, parameters.getValue (index) * (key == 'F' ? 1.25f : .8f));
+        }
+        else if (key == 'g' || key == 'G')
+        {
+            const int index = AudioProcessing::noiseGainParameter;
+            setParameter (parameters, index, parameters.getValue (index) + (key == 'G' ? .05f : -.05f));
+        }
+        else if (key == 'i')
+        {
+            const int index = AudioProcessing::channelModeParameter;
+            setParameter (parameters, index, parameters.getValue (index) < .5f ? 1.0f : 0.0f);
+        }
+        else if (key == 'l')
+        {
+            const int index = AudioProcessing::lfoShapeParameter;
+            setParameter (parameters, index, parameters.getValue (index) < 2.5f ? parameters.getValue (index) + 1 : 0.0f);
+        }
+        else if (key == 'k' || key == 'K')
+        {
+            const int index = AudioProcessing::controlIntervalParameter;
+            setParameter (parameters, index, parameters.getValue (index) * (key == 'K' ? 2.0f : .5f));
+        }
+        else if (key == 'n')
+        {
+            const int index = AudioProcessing::noiseColourParameter;
+            setParameter (parameters, index, parameters.getValue (index) < 1.5f ? parameters.getValue (index) + 1 : 0.0f);
+        }
+        else if (key == 'm')
+        {
+            const int index = AudioProcessing::sourceParameter;
+            setParameter (parameters, index, parameters.getValue (index) < .5f ? 1.0f : 0.0f);
+        }
+        
 //        digitalWrite (0, HIGH) ; delay (500) ;
 //        printf("on\n");
 //        digitalWrite (0,  LOW) ; delay (500) ;
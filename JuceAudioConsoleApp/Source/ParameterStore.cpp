@@ -0,0 +1,97 @@
+//
+//  ParameterStore.cpp
+//
+
+#include "ParameterStore.hpp"
+
+//==============================================================================
+int ParameterStore::addParameter(const String& name, float defaultValue, float minValue, float maxValue,
+                                 Smoothing smoothing)
+{
+    jassert(numParameters < maxParameters);
+
+    Parameter& parameter = parameters[numParameters];
+    parameter.name = name;
+    parameter.minValue = minValue;
+    parameter.maxValue = maxValue;
+    parameter.smoothing = smoothing;
+    parameter.target = jlimit(minValue, maxValue, defaultValue);
+    parameter.current = parameter.rampTarget = parameter.blockStart = parameter.target;
+
+    return numParameters++;
+}
+
+void ParameterStore::prepare(double sampleRate, double rampLengthSeconds)
+{
+    rampLengthSamples = jmax(0, roundToInt(sampleRate * rampLengthSeconds));
+    changedMask = 0;
+
+    for (int i = 0; i < numParameters; ++i)
+    {
+        Parameter& parameter = parameters[i];
+        parameter.current = parameter.rampTarget = parameter.blockStart = parameter.target;
+        parameter.step = 0;
+        parameter.samplesLeft = parameter.blockRampLength = 0;
+        parameter.changing = false;
+    }
+}
+//==============================================================================
+void ParameterStore::setValue(int index, float newValue)
+{
+    jassert(isPositiveAndBelow(index, numParameters));
+
+    Parameter& parameter = parameters[index];
+    parameter.target = jlimit(parameter.minValue, parameter.maxValue, newValue);
+    changedMask.fetch_or(1u << index);
+}
+//==============================================================================
+void ParameterStore::beginBlock(int numSamples) noexcept
+{
+    const uint32 changed = changedMask.exchange(0);
+
+    for (int i = 0; i < numParameters; ++i)
+    {
+        Parameter& parameter = parameters[i];
+        parameter.blockStart = parameter.current;
+        bool jumped = false;
+
+        if ((changed & (1u << i)) != 0)
+        {
+            parameter.rampTarget = parameter.target.load();
+
+            if (parameter.smoothing == Smoothing::none || rampLengthSamples == 0)
+            {
+                jumped = parameter.rampTarget != parameter.current;
+                parameter.current = parameter.blockStart = parameter.rampTarget;
+                parameter.samplesLeft = 0;
+            }
+            else
+            {
+                parameter.samplesLeft = rampLengthSamples;
+                parameter.step = (parameter.rampTarget - parameter.current) / rampLengthSamples;
+            }
+        }
+
+        parameter.blockRampLength = parameter.samplesLeft;
+        parameter.changing = jumped || parameter.samplesLeft > 0;
+
+        if (parameter.samplesLeft > 0)
+        {
+            const int rampSamples = jmin(numSamples, parameter.samplesLeft);
+            parameter.samplesLeft -= rampSamples;
+            parameter.current = parameter.samplesLeft > 0 ? parameter.current + parameter.step * rampSamples
+                                                          : parameter.rampTarget;
+        }
+    }
+}
+
+void ParameterStore::fillBuffer(int index, float* dest, int numSamples) const noexcept
+{
+    const Parameter& parameter = parameters[index];
+    const int rampSamples = jmin(numSamples, parameter.blockRampLength - 1);
+
+    for (int i = 0; i < rampSamples; ++i)
+        dest[i] = parameter.blockStart + parameter.step * (i + 1);
+
+    FloatVectorOperations::fill(dest + jmax(0, rampSamples), parameter.rampTarget, numSamples - jmax(0, rampSamples));
+}
@@ -0,0 +1,133 @@
+//
+//  ParameterStore.hpp
+//
+//  Parameters the control side can change while the device runs, picked up
+//  and smoothed by the audio thread once per block.
+//
+
+#ifndef ParameterStore_hpp
+#define ParameterStore_hpp
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+ ParameterStore class: each parameter is an atomic target value and a bit in
+ an atomic change mask. The control side stores the target then sets the bit;
+ the audio thread swaps the mask for zero at the start of each block and only
+ looks at the parameters whose bits were set, so neither side ever waits.
+
+ Changed values are ramped linearly to the new target, either once per block
+ or per sample, and isChanging() tells the audio thread which parameters it
+ needs to recompute anything for.
+
+ Parameters are added before prepare(); there can be at most maxParameters.
+ */
+class ParameterStore
+{
+public:
+    //==============================================================================
+    /** how a parameter moves to a new value */
+    enum class Smoothing
+    {
+        none,       /**< jumps at the next block */
+        perBlock,   /**< ramps, read once per block with getBlockValue() */
+        perSample   /**< ramps, read per sample with fillBuffer() */
+    };
+
+    static const int maxParameters = 32;
+    //==============================================================================
+    ParameterStore(){};
+    ~ParameterStore(){};
+    //==============================================================================
+    /**
+     adds a parameter. Not real time safe.
+
+     @param name name to show for it
+     @param defaultValue starting value
+     @param minValue lowest value setValue() will store
+     @param maxValue highest value setValue() will store
+     @param smoothing how the audio thread moves to new values
+     @returns the index to refer to it by
+     */
+    int addParameter(const String& name, float defaultValue, float minValue, float maxValue,
+                     Smoothing smoothing);
+
+    /**
+     sets the ramp length and jumps every parameter to its value. Not real time
+     safe, call before the audio thread starts using the store.
+
+     @param sampleRate sample rate the audio thread runs at
+     @param rampLengthSeconds how long a smoothed parameter takes to reach a new value
+     */
+    void prepare(double sampleRate, double rampLengthSeconds);
+    //==============================================================================
+    /**
+     sets a parameter from the control side. Wait-free, never blocks the audio thread.
+
+     @param index parameter index
+     @param newValue new value, limited to the parameter's range
+     */
+    void setValue(int index, float newValue);
+
+    /** @returns the value last set from the control side */
+    float getValue(int index) const { return parameters[index].target.load(); }
+
+    /** @returns the name of a parameter */
+    const String& getName(int index) const { return parameters[index].name; }
+
+    /** @returns the number of parameters added */
+    int getNumParameters() const { return numParameters; }
+    //==============================================================================
+    /**
+     picks up new values and moves every ramp on by a block. Audio thread only,
+     call once at the start of each block before reading any values.
+
+     @param numSamples length of the block
+     */
+    void beginBlock(int numSamples) noexcept;
+
+    /** @returns true if the parameter moves during this block. Audio thread only */
+    bool isChanging(int index) const noexcept { return parameters[index].changing; }
+
+    /** @returns the value at the end of this block. Audio thread only */
+    float getBlockValue(int index) const noexcept { return parameters[index].current; }
+
+    /**
+     writes the parameter's value for each sample of this block. Audio thread only.
+     Samples past the end of the block carry on the ramp or hold the target, so a
+     buffer longer than the block is still valid for the next block if the
+     parameter is not changing then.
+
+     @param index parameter index
+     @param dest buffer of numSamples
+     @param numSamples number of samples to write, may be longer than the block
+     */
+    void fillBuffer(int index, float* dest, int numSamples) const noexcept;
+
+private:
+    //==============================================================================
+    struct Parameter
+    {
+        /** written by the control side */
+        std::atomic<float> target {0};
+
+        String name;
+        float minValue = 0, maxValue = 1;
+        Smoothing smoothing = Smoothing::none;
+
+        /** audio thread ramp state */
+        float current = 0, step = 0, rampTarget = 0, blockStart = 0;
+        int samplesLeft = 0, blockRampLength = 0;
+        bool changing = false;
+    };
+    //==============================================================================
+    Parameter parameters[maxParameters];
+    int numParameters = 0;
+    /** one bit per parameter, set when its target has changed */
+    std::atomic<uint32> changedMask {0};
+    int rampLengthSamples = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(ParameterStore)
+};
+
+#endif /* ParameterStore_hpp */
@@ -0,0 +1,201 @@
+//
+//  RealtimeMode.cpp
+//
+
+#include "RealtimeMode.hpp"
+
+#include <cerrno>
+
+#if JUCE_LINUX
+ #include <sys/mman.h>
+ #include <sys/resource.h>
+ #include <malloc.h>
+ #include <pthread.h>
+ #include <sched.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    /** stack touched on each thread, well inside the 8 MB Linux default */
+    const int stackPrefaultBytes = 256 * 1024;
+    /** heap touched and handed back to malloc to be reused without faulting */
+    const size_t heapReserveBytes = 8 * 1024 * 1024;
+
+    size_t getPageSize()
+    {
+#if JUCE_LINUX
+        return (size_t) jmax(1024L, sysconf(_SC_PAGESIZE));
+#else
+        return 4096;
+#endif
+    }
+
+    /** faults in the pages under the caller's frame */
+    void prefaultStack() noexcept
+    {
+        volatile char stack[stackPrefaultBytes];
+
+        // a write every 1 KB hits every page whatever the page size
+        for (int i = 0; i < stackPrefaultBytes; i += 1024)
+            stack[i] = 0;
+
+        ignoreUnused(stack);
+    }
+
+    /** @returns a description of an errno, or of -1 for unsupported steps */
+    String describeError(int error)
+    {
+        return error < 0 ? String("not supported on this platform") : String(strerror(error));
+    }
+
+#if JUCE_LINUX
+    /** @returns a soft resource limit as text */
+    String getLimit(int resource, int64 divisor)
+    {
+        rlimit limit;
+        if (getrlimit(resource, &limit) != 0)
+            return "unknown";
+
+        return limit.rlim_cur == RLIM_INFINITY ? String("unlimited") : String((int64) limit.rlim_cur / divisor);
+    }
+#endif
+}
+//==============================================================================
+void RealtimeMode::enable(const Options& newOptions)
+{
+    options = newOptions;
+
+    if (! options.enabled)
+        return;
+
+#if JUCE_LINUX
+    // keep freed memory in the heap instead of returning it, and serve even
+    // large blocks from the heap, so a page once faulted stays faulted
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    lockError = mlockall(MCL_CURRENT | MCL_FUTURE) == 0 ? 0 : errno;
+
+    // with the memory locked this is already resident; without, it is at
+    // least resident for now
+    if (char* reserve = static_cast<char*>(malloc(heapReserveBytes)))
+    {
+        prefault(reserve, heapReserveBytes);
+        free(reserve);
+    }
+
+    prefaultStack();
+#else
+    lockError = -1;
+#endif
+
+    rearm();
+}
+
+void RealtimeMode::rearm() noexcept
+{
+    if (! options.enabled)
+        return;
+
+    appliedThread = nullptr;
+    pending = true;
+}
+
+void RealtimeMode::applyToCurrentThread() noexcept
+{
+#if JUCE_LINUX
+    sched_param param {};
+    param.sched_priority = jlimit(sched_get_priority_min(SCHED_FIFO),
+                                  sched_get_priority_max(SCHED_FIFO), options.priority);
+    scheduleError = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+
+    if (options.cpu >= 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+
+        if (options.cpu < CPU_SETSIZE)
+        {
+            CPU_SET(options.cpu, &cpus);
+            affinityError = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        }
+        else
+        {
+            affinityError = EINVAL;
+        }
+    }
+
+    prefaultStack();
+#else
+    scheduleError = affinityError = -1;
+#endif
+
+    pending.store(false, std::memory_order_relaxed);
+    ++numThreadsApplied;
+    appliedThread = Thread::getCurrentThreadId();
+}
+//==============================================================================
+String RealtimeMode::getReport() const
+{
+    if (! options.enabled)
+        return "realtime mode off, run with --rt to enable it\n";
+
+    String report;
+
+    if (lockError == 0)
+        report << "memory locked and prefaulted\n";
+    else
+        report << "could not lock memory (" << describeError(lockError) << "), pages may be swapped out. "
+#if JUCE_LINUX
+               << "The memlock limit is " << getLimit(RLIMIT_MEMLOCK, 1024) << " KB: "
+               << "raise memlock in /etc/security/limits.conf or give the binary CAP_IPC_LOCK"
+#endif
+               << "\n";
+
+    const Thread::ThreadID thread = appliedThread.load();
+    if (thread == nullptr)
+        return report + "audio thread not set up yet, waiting for the first callback\n";
+
+    // a reopened device has a new thread, so say which one the lines below are about
+    const int numThreads = numThreadsApplied.load();
+    report << "set up audio thread 0x" << String::toHexString((pointer_sized_int) thread) << ", "
+           << numThreads << (numThreads == 1 ? " thread" : " threads") << " set up since enabled\n";
+
+    if (scheduleError == 0)
+        report << "audio thread at SCHED_FIFO priority " << options.priority << "\n";
+    else
+        report << "could not make the audio thread SCHED_FIFO (" << describeError(scheduleError)
+               << "), it keeps the default scheduling. "
+#if JUCE_LINUX
+               << "The rtprio limit is " << getLimit(RLIMIT_RTPRIO, 1) << ": "
+               << "raise rtprio in /etc/security/limits.conf, run as root or "
+               << "setcap cap_sys_nice+ep on the binary"
+#endif
+               << "\n";
+
+    if (options.cpu >= 0)
+    {
+        if (affinityError == 0)
+            report << "audio thread pinned to CPU " << options.cpu << "\n";
+        else
+            report << "could not pin the audio thread to CPU " << options.cpu
+                   << " (" << describeError(affinityError) << "), it runs on any of the "
+                   << SystemStats::getNumCpus() << " CPUs\n";
+    }
+
+    return report;
+}
+//==============================================================================
+void RealtimeMode::prefault(void* data, size_t numBytes)
+{
+    volatile char* bytes = static_cast<char*>(data);
+    const size_t pageSize = getPageSize();
+
+    // a write is needed, a read would only map the shared zero page
+    for (size_t i = 0; i < numBytes; i += pageSize)
+        bytes[i] = bytes[i];
+
+    if (numBytes > 0)
+        bytes[numBytes - 1] = bytes[numBytes - 1];
+}
@@ -0,0 +1,119 @@
+//
+//  RealtimeMode.hpp
+//
+//  Opt-in hardening of the audio callback thread: locked and prefaulted
+//  memory, SCHED_FIFO and a pinned CPU, reporting each step that the process
+//  is not allowed to take.
+//
+
+#ifndef RealtimeMode_hpp
+#define RealtimeMode_hpp
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+ RealtimeMode class: enable() does the parts that belong to the whole
+ process, on the thread setting things up: it stops malloc handing memory
+ back to the system, locks every current and future page with mlockall(),
+ and touches a heap reserve and its own stack so they are resident before
+ the device starts.
+
+ The scheduling has to be set from the audio thread itself, which JUCE owns,
+ so the first callback after enable() calls applyToCallbackThread(), which
+ switches that thread to SCHED_FIFO, pins it to a CPU and prefaults its
+ stack. Every later callback only pays for a relaxed atomic load. A device
+ that stops and opens again calls back on a new thread, so rearm() has the
+ next callback set that one up too.
+
+ Each step that fails is recorded with its errno rather than stopping
+ anything: without the privileges the app keeps running with the default
+ scheduling and pageable memory, and getReport() says what was missing and
+ how to grant it.
+ */
+class RealtimeMode
+{
+public:
+    //==============================================================================
+    /** what to ask for */
+    struct Options
+    {
+        /** false leaves the process and the audio thread as they are */
+        bool enabled = false;
+        /** SCHED_FIFO priority of the audio thread, 1 to 99 */
+        int priority = 80;
+        /** CPU to pin the audio thread to, e.g. one kept free with isolcpus, or -1 for any */
+        int cpu = -1;
+    };
+    //==============================================================================
+    RealtimeMode() {}
+    //==============================================================================
+    /**
+     locks memory and prefaults the calling thread's stack and the heap, and
+     arms applyToCallbackThread(). Not real time safe; call before the
+     buffers are allocated and the device is opened, so they are locked too.
+
+     @param newOptions what to ask for, nothing happens unless enabled
+     */
+    void enable(const Options& newOptions);
+
+    /** @returns true once enable() has been called with options that are enabled */
+    bool isEnabled() const { return options.enabled; }
+
+    /**
+     has the next applyToCallbackThread() set up its thread again, for a
+     device about to start calling back, possibly on a new thread. Call from
+     audioDeviceAboutToStart(), while no callback is running. Does nothing
+     unless enabled.
+     */
+    void rearm() noexcept;
+
+    /**
+     applies the scheduling to the calling thread the first time it is called
+     after enable() or rearm(). Call at the start of every audio callback.
+     */
+    void applyToCallbackThread() noexcept
+    {
+        if (pending.load(std::memory_order_relaxed))
+            applyToCurrentThread();
+    }
+
+    /** @returns true once the current audio thread has been through applyToCallbackThread() */
+    bool hasApplied() const { return appliedThread.load() != nullptr; }
+
+    /**
+     @returns a line for each step saying whether it worked and, if not, what
+              privilege was missing, naming the audio thread the steps were
+              taken on. Read hasApplied() first for the audio thread's steps.
+     */
+    String getReport() const;
+    //==============================================================================
+    /**
+     writes every page of a buffer so it is backed by memory before the audio
+     thread reads it. Not real time safe, and nothing else may be using the
+     buffer at the same time.
+
+     @param data buffer to touch, left unchanged
+     @param numBytes size of the buffer
+     */
+    static void prefault(void* data, size_t numBytes);
+
+private:
+    //==============================================================================
+    /** the audio thread's part, run once */
+    void applyToCurrentThread() noexcept;
+    //==============================================================================
+    Options options;
+    /** set by enable() and rearm(), cleared by the audio thread once it has applied the options */
+    std::atomic<bool> pending {false};
+    /** the audio thread last set up, stored after it has written its errors,
+        or nullptr while waiting for one */
+    std::atomic<Thread::ThreadID> appliedThread {nullptr};
+    /** number of audio threads set up so far */
+    std::atomic<int> numThreadsApplied {0};
+    /** errno of each step, 0 when it worked, -1 when not supported here */
+    int lockError = 0, scheduleError = 0, affinityError = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(RealtimeMode)
+};
+
+#endif /* RealtimeMode_hpp */
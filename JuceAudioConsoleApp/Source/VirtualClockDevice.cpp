@@ -0,0 +1,262 @@
+//
+//  VirtualClockDevice.cpp
+//
+
+#include "VirtualClockDevice.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace
+{
+    /** sleeps until a time on the high resolution clock, to well under a millisecond */
+    void sleepUntil(int64 targetTicks)
+    {
+        const int64 remainingTicks = targetTicks - Time::getHighResolutionTicks();
+
+        if (remainingTicks > 0)
+            std::this_thread::sleep_for(std::chrono::microseconds((int64) (1.0e6 * remainingTicks
+                                                                           / Time::getHighResolutionTicksPerSecond())));
+    }
+
+    /** atomically raises value to at least candidate; only one thread ever writes it */
+    void storeMax(std::atomic<int64>& value, int64 candidate)
+    {
+        if (candidate > value.load(std::memory_order_relaxed))
+            value.store(candidate, std::memory_order_relaxed);
+    }
+}
+//==============================================================================
+VirtualClockDevice::VirtualClockDevice(const String& name, const String& deviceTypeName, const Options& clockOptions)
+    : AudioIODevice(name, deviceTypeName), Thread("virtual clock"), options(clockOptions)
+{
+}
+
+VirtualClockDevice::~VirtualClockDevice()
+{
+    close();
+}
+//==============================================================================
+StringArray VirtualClockDevice::getOutputChannelNames()
+{
+    StringArray names;
+    for (int i = 0; i < options.numOutputChannels; ++i)
+        names.add("Output " + String(i + 1));
+    return names;
+}
+
+StringArray VirtualClockDevice::getInputChannelNames()
+{
+    return StringArray();
+}
+
+Array<double> VirtualClockDevice::getAvailableSampleRates()
+{
+    Array<double> rates;
+    rates.add(options.sampleRate);
+    return rates;
+}
+
+Array<int> VirtualClockDevice::getAvailableBufferSizes()
+{
+    Array<int> sizes;
+    sizes.add(options.blockSize);
+    return sizes;
+}
+
+int VirtualClockDevice::getDefaultBufferSize()
+{
+    return options.blockSize;
+}
+//==============================================================================
+String VirtualClockDevice::open(const BigInteger&, const BigInteger& outputChannels,
+                                double newSampleRate, int bufferSizeSamples)
+{
+    close();
+
+    sampleRate = newSampleRate > 0 ? newSampleRate : options.sampleRate;
+    blockSize = bufferSizeSamples > 0 ? bufferSizeSamples : options.blockSize;
+    const int requestedChannels = outputChannels.getHighestBit() + 1;
+    numChannels = jmax(1, requestedChannels > 0 ? jmin(requestedChannels, options.numOutputChannels)
+                                                : options.numOutputChannels);
+
+    renderBuffer.setSize(numChannels, blockSize);
+    numBlocks = numMissed = numSkipped = 0;
+    maxWakeLateTicks = maxOverrunTicks = 0;
+    opened = true;
+
+    // the clock stands in for a sound card's audio thread, so it runs at the
+    // priority AlsaMmapDevice's thread does and a load test competes for the
+    // CPU the way a real run would
+    startThread(9);
+    return String();
+}
+
+void VirtualClockDevice::close()
+{
+    stop();
+    stopThread(2000);
+    opened = false;
+}
+
+bool VirtualClockDevice::isOpen()
+{
+    return opened;
+}
+//==============================================================================
+void VirtualClockDevice::start(AudioIODeviceCallback* newCallback)
+{
+    if (newCallback != nullptr)
+        newCallback->audioDeviceAboutToStart(this);
+
+    const ScopedLock sl(callbackLock);
+    callback = newCallback;
+}
+
+void VirtualClockDevice::stop()
+{
+    AudioIODeviceCallback* oldCallback;
+
+    {
+        const ScopedLock sl(callbackLock);
+        oldCallback = callback;
+        callback = nullptr;
+    }
+
+    if (oldCallback != nullptr)
+        oldCallback->audioDeviceStopped();
+}
+
+bool VirtualClockDevice::isPlaying()
+{
+    return isThreadRunning() && callback != nullptr;
+}
+
+String VirtualClockDevice::getLastError()
+{
+    return String();
+}
+//==============================================================================
+int VirtualClockDevice::getCurrentBufferSizeSamples() { return blockSize; }
+double VirtualClockDevice::getCurrentSampleRate() { return sampleRate; }
+int VirtualClockDevice::getCurrentBitDepth() { return 32; }
+
+BigInteger VirtualClockDevice::getActiveOutputChannels() const
+{
+    BigInteger channels;
+    channels.setRange(0, numChannels, true);
+    return channels;
+}
+
+BigInteger VirtualClockDevice::getActiveInputChannels() const { return BigInteger(); }
+int VirtualClockDevice::getOutputLatencyInSamples() { return blockSize; }
+int VirtualClockDevice::getInputLatencyInSamples() { return 0; }
+int VirtualClockDevice::getXRunCount() const noexcept { return (int) numMissed.load(); }
+//==============================================================================
+String VirtualClockDevice::getClockReport() const
+{
+    if (! opened)
+        return getName() + " not open\n";
+
+    const double microsPerTick = 1.0e6 / Time::getHighResolutionTicksPerSecond();
+    String report;
+    report << getName() << ": " << String(sampleRate, 0) << " Hz, " << numChannels << " channels, "
+           << blockSize << " samples per callback (" << String(blockSize * 1000.0 / sampleRate, 2)
+           << " ms deadline), jitter up to " << String(options.maxJitterMs, 2) << " ms, seed "
+           << options.seed << "\n"
+           << "callbacks " << numBlocks.load() << ", missed deadlines " << numMissed.load()
+           << ", periods skipped " << numSkipped.load() << "\n"
+           << "worst wake up " << String(maxWakeLateTicks.load() * microsPerTick, 1)
+           << " us late, worst finish " << String(maxOverrunTicks.load() * microsPerTick, 1)
+           << " us past the deadline\n";
+    return report;
+}
+//==============================================================================
+void VirtualClockDevice::run()
+{
+    const double ticksPerBlock = blockSize * Time::getHighResolutionTicksPerSecond() / sampleRate;
+    const double maxJitterTicks = options.maxJitterMs * .001 * Time::getHighResolutionTicksPerSecond();
+    Random jitter(options.seed);
+
+    const int64 startTicks = Time::getHighResolutionTicks();
+    int64 block = 0;
+
+    while (! threadShouldExit())
+    {
+        const int64 dueTicks = startTicks + (int64) (block * ticksPerBlock);
+        const int64 deadlineTicks = startTicks + (int64) ((block + 1) * ticksPerBlock);
+
+        sleepUntil(dueTicks + (int64) (jitter.nextDouble() * maxJitterTicks));
+
+        storeMax(maxWakeLateTicks, Time::getHighResolutionTicks() - dueTicks);
+        renderBlock();
+        const int64 finishedTicks = Time::getHighResolutionTicks();
+
+        numBlocks.store(numBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        ++block;
+
+        if (finishedTicks > deadlineTicks)
+        {
+            numMissed.store(numMissed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            storeMax(maxOverrunTicks, finishedTicks - deadlineTicks);
+
+            // the periods the callback ran into have been played as silence,
+            // so the next block is the first one still due
+            const int64 nextBlock = (int64) std::ceil((finishedTicks - startTicks) / ticksPerBlock);
+            numSkipped.store(numSkipped.load(std::memory_order_relaxed) + nextBlock - block,
+                             std::memory_order_relaxed);
+            block = nextBlock;
+        }
+    }
+}
+
+void VirtualClockDevice::renderBlock()
+{
+    const ScopedTryLock sl(callbackLock);
+
+    if (sl.isLocked() && callback != nullptr)
+        callback->audioDeviceIOCallback(nullptr, 0, renderBuffer.getArrayOfWritePointers(),
+                                        numChannels, blockSize);
+    else
+        renderBuffer.clear();
+}
+//==============================================================================
+const char* const VirtualClockDeviceType::typeName = "Virtual clock";
+
+VirtualClockDeviceType::VirtualClockDeviceType(const VirtualClockDevice::Options& clockOptions)
+    : AudioIODeviceType(typeName), options(clockOptions)
+{
+}
+
+void VirtualClockDeviceType::scanForDevices()
+{
+}
+
+StringArray VirtualClockDeviceType::getDeviceNames(bool wantInputNames) const
+{
+    StringArray names;
+    if (! wantInputNames)
+        names.add(typeName);
+    return names;
+}
+
+int VirtualClockDeviceType::getDefaultDeviceIndex(bool forInput) const
+{
+    return forInput ? -1 : 0;
+}
+
+int VirtualClockDeviceType::getIndexOfDevice(AudioIODevice* device, bool asInput) const
+{
+    return (asInput || device == nullptr) ? -1 : getDeviceNames().indexOf(device->getName());
+}
+
+bool VirtualClockDeviceType::hasSeparateInputsAndOutputs() const
+{
+    return true;
+}
+
+AudioIODevice* VirtualClockDeviceType::createDevice(const String& outputDeviceName, const String&)
+{
+    return outputDeviceName.isEmpty() || outputDeviceName == typeName
+               ? new VirtualClockDevice(typeName, typeName, options) : nullptr;
+}
@@ -0,0 +1,142 @@
+//
+//  VirtualClockDevice.hpp
+//
+//  Output device with no hardware behind it: a thread calls the audio callback
+//  on a fixed clock, optionally waking it late by a random amount, and counts
+//  the callbacks that finish after their deadline.
+//
+
+#ifndef VirtualClockDevice_hpp
+#define VirtualClockDevice_hpp
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+ VirtualClockDevice class: an output only AudioIODevice for machines without
+ a sound card, so AudioDeviceManager opens, starts and stops it, and runs
+ audioDeviceAboutToStart(), the callbacks and audioDeviceStopped(), exactly
+ as it would a real device.
+
+ Block n is due to be woken at start + n periods and has to be finished one
+ period later, when a double buffered device would start playing it. The
+ thread sleeps until the wake up time plus a random jitter drawn from a
+ seeded Random, so a run is repeatable, calls the callback, and checks the
+ deadline. A callback that misses it is counted, and the clock skips the
+ periods it ran into, as a device playing silence through them would; the
+ next block is woken on the next period boundary.
+
+ Like AlsaMmapDevice it only tries the callback lock, and renders silence
+ when it can't take it.
+ */
+class VirtualClockDevice : public AudioIODevice, private Thread
+{
+public:
+    //==============================================================================
+    /** how the clock runs */
+    struct Options
+    {
+        double sampleRate = 48000;
+        /** samples per callback, when open() is not given a buffer size. The
+            app always passes AudioDeviceOptions::periodSize */
+        int blockSize = 64;
+        int numOutputChannels = 2;
+        /** each wake up is late by a uniform random time up to this */
+        double maxJitterMs = 0;
+        /** seed of the jitter sequence */
+        int64 seed = 1;
+    };
+    //==============================================================================
+    /**
+     @param name device name
+     @param typeName name of the VirtualClockDeviceType creating it
+     @param options rate, block size and jitter to run with
+     */
+    VirtualClockDevice(const String& name, const String& typeName, const Options& options);
+    ~VirtualClockDevice();
+    //==============================================================================
+    StringArray getOutputChannelNames() override;
+    StringArray getInputChannelNames() override;
+    Array<double> getAvailableSampleRates() override;
+    Array<int> getAvailableBufferSizes() override;
+    int getDefaultBufferSize() override;
+
+    String open(const BigInteger& inputChannels, const BigInteger& outputChannels,
+                double sampleRate, int bufferSizeSamples) override;
+    void close() override;
+    bool isOpen() override;
+
+    void start(AudioIODeviceCallback* callback) override;
+    void stop() override;
+    bool isPlaying() override;
+    String getLastError() override;
+
+    int getCurrentBufferSizeSamples() override;
+    double getCurrentSampleRate() override;
+    int getCurrentBitDepth() override;
+    BigInteger getActiveOutputChannels() const override;
+    BigInteger getActiveInputChannels() const override;
+    int getOutputLatencyInSamples() override;
+    int getInputLatencyInSamples() override;
+    /** @returns the missed deadlines */
+    int getXRunCount() const noexcept override;
+    //==============================================================================
+    /**
+     @returns the clock settings, the callbacks run, the deadlines missed and
+              periods skipped, and the worst wake up and finishing times
+     */
+    String getClockReport() const;
+
+private:
+    //==============================================================================
+    void run() override;
+    /** renders one block with the callback, or silence if there is none */
+    void renderBlock();
+    //==============================================================================
+    const Options options;
+
+    bool opened = false;
+    double sampleRate = 0;
+    int blockSize = 0, numChannels = 0;
+    AudioBuffer<float> renderBuffer;
+
+    CriticalSection callbackLock;
+    AudioIODeviceCallback* callback = nullptr;
+
+    /** written by the clock thread only */
+    std::atomic<int64> numBlocks {0}, numMissed {0}, numSkipped {0};
+    /** worst wake up after the nominal time, and worst finish after the deadline */
+    std::atomic<int64> maxWakeLateTicks {0}, maxOverrunTicks {0};
+
+    JUCE_DECLARE_NON_COPYABLE(VirtualClockDevice)
+};
+
+//==============================================================================
+/**
+ VirtualClockDeviceType class: offers a single VirtualClockDevice to
+ AudioDeviceManager.
+ */
+class VirtualClockDeviceType : public AudioIODeviceType
+{
+public:
+    //==============================================================================
+    /** the type name, which is also the name of its one device */
+    static const char* const typeName;
+    //==============================================================================
+    /** @param options how the device's clock runs */
+    VirtualClockDeviceType(const VirtualClockDevice::Options& options);
+    //==============================================================================
+    void scanForDevices() override;
+    StringArray getDeviceNames(bool wantInputNames = false) const override;
+    int getDefaultDeviceIndex(bool forInput) const override;
+    int getIndexOfDevice(AudioIODevice* device, bool asInput) const override;
+    bool hasSeparateInputsAndOutputs() const override;
+    AudioIODevice* createDevice(const String& outputDeviceName, const String& inputDeviceName) override;
+
+private:
+    //==============================================================================
+    const VirtualClockDevice::Options options;
+
+    JUCE_DECLARE_NON_COPYABLE(VirtualClockDeviceType)
+};
+
+#endif /* VirtualClockDevice_hpp */
@@ -0,0 +1,119 @@
+#include "BlockLFO.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    /** fills the sine table before main() runs */
+    struct SineTable
+    {
+        /** number of intervals in a cycle, the top bits of the phase */
+        static const int bits = 10, size = 1 << bits;
+
+        SineTable()
+        {
+            for (int i = 0; i <= size; i++)
+                values[i] = (float) sin(2 * 3.14159265358979323846 * i / size);
+        }
+
+        float values[size+1];
+    };
+
+    const SineTable sineTable;
+
+    /** 2^32: one cycle of phase */
+    const double phaseRange = 4294967296.0;
+}
+//==============================================================================
+void BlockLFO::init(double extSampRate)
+{
+    sampleRate = extSampRate;
+    setFrequency(frequency);
+}
+
+void BlockLFO::setFrequency(double hz)
+{
+    frequency = hz;
+    const double cycles = std::fmod(std::fabs(hz) / sampleRate, 1.0);
+    increment = (uint32_t) (int64_t) std::floor(cycles * phaseRange + 0.5);
+}
+
+void BlockLFO::setPhase(double cycles)
+{
+    cycles -= std::floor(cycles);
+    phase = (uint32_t) (int64_t) (cycles * phaseRange);
+}
+//==============================================================================
+void BlockLFO::process(float* dest, const int numSamples)
+{
+    if (shape == Shape::sine)
+    {
+        // the common case, kept free of the shape switch
+        const int fracBits = 32 - SineTable::bits;
+        const float fracScale = 1.0f / (1 << fracBits);
+
+        for (int n = 0; n < numSamples; n++)
+        {
+            const uint32_t i = phase >> fracBits;
+            const float frac = (phase & ((1u << fracBits) - 1)) * fracScale;
+            dest[n] = sineTable.values[i] + frac*(sineTable.values[i+1] - sineTable.values[i]);
+            phase += increment;
+        }
+        return;
+    }
+
+    for (int n = 0; n < numSamples; n++)
+    {
+        dest[n] = valueAt(phase);
+        step(1);
+    }
+}
+
+float BlockLFO::advance(const int numSamples)
+{
+    const float value = valueAt(phase);
+    step((uint64_t) std::max(0, numSamples));
+    return value;
+}
+//==============================================================================
+float BlockLFO::valueAt(const uint32_t p) const
+{
+    switch (shape)
+    {
+        case Shape::sine:
+        {
+            const int fracBits = 32 - SineTable::bits;
+            const uint32_t i = p >> fracBits;
+            const float frac = (p & ((1u << fracBits) - 1)) * (1.0f / (1 << fracBits));
+            return sineTable.values[i] + frac*(sineTable.values[i+1] - sineTable.values[i]);
+        }
+        case Shape::triangle:
+        {
+            // a quarter cycle ahead, so it starts at 0 going up
+            const double t = (uint32_t) (p + 0x40000000u) * (1.0 / phaseRange);
+            return (float) (1 - 4 * std::fabs(t - 0.5));
+        }
+        case Shape::saw:
+        {
+            // half a cycle ahead, so it starts at 0
+            const double t = (uint32_t) (p + 0x80000000u) * (1.0 / phaseRange);
+            return (float) (2 * t - 1);
+        }
+        default:
+            return held;
+    }
+}
+
+void BlockLFO::step(const uint64_t numSamples)
+{
+    const uint64_t next = phase + increment * numSamples;
+
+    // past a multiple of 2^32: at least one new cycle began
+    if (shape == Shape::sampleAndHold && (next >> 32) != 0)
+    {
+        random.fill(&held, 1);
+        held *= 2;
+    }
+
+    phase = (uint32_t) next;
+}
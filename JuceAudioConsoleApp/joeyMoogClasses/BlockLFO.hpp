@@ -0,0 +1,115 @@
+//
+//  BlockLFO.hpp
+//
+//  Low frequency oscillator for the side chains, run a block or a control
+//  tick at a time. Sine, triangle, saw or sample and hold.
+//
+
+#ifndef BlockLFO_hpp
+#define BlockLFO_hpp
+
+#include <cstdint>
+#include "BlockNoise.hpp"
+
+/**
+ BlockLFO class: Initialised with sample rate (getSampleRate() in JUCE).
+
+ The phase is a 32 bit integer that wraps by overflowing, so it never loses
+ precision however long the oscillator runs, and one cycle is exactly 2^32.
+ The sine is read from an interpolated table rather than calling sin().
+
+ Every shape is in [-1, 1] and, apart from sample and hold, starts at 0
+ going up.
+ */
+class BlockLFO
+{
+public:
+    //==========================================================================
+    /** waveform of the oscillator */
+    enum class Shape
+    {
+        sine,           /**< table lookup, max error about 5e-6 */
+        triangle,       /**< rises for the first quarter */
+        saw,            /**< rising ramp */
+        sampleAndHold   /**< new random value at the start of every cycle */
+    };
+    //==========================================================================
+    /** Constructor */
+    BlockLFO(){};
+    BlockLFO(double extSampRate)
+    {
+        init(extSampRate);
+    };
+    /** Destructor */
+    ~BlockLFO(){};
+    //==========================================================================
+    /**
+     sets the sample rate, keeping the frequency in Hz
+
+     @param extSampRate sample rate of environment
+     */
+    void init(double extSampRate);
+
+    /**
+     @param hz frequency, quantised to sampleRate/2^32
+     */
+    void setFrequency(double hz);
+
+    /** @returns the frequency in Hz */
+    double getFrequency() const { return frequency; }
+
+    /**
+     changes the waveform from the next sample, keeping the phase
+
+     @param newShape waveform
+     */
+    void setShape(Shape newShape) { shape = newShape; }
+
+    /** @returns the waveform */
+    Shape getShape() const { return shape; }
+
+    /**
+     moves the phase, e.g. to restart or to line up several oscillators
+
+     @param cycles phase in cycles, wrapped into [0, 1)
+     */
+    void setPhase(double cycles);
+
+    /** @returns the phase in cycles, [0, 1) */
+    double getPhase() const { return phase * (1.0 / 4294967296.0); }
+    //==========================================================================
+    /**
+     writes the next numSamples values at audio rate
+
+     @param dest buffer of numSamples
+     @param numSamples number of samples, any size
+     */
+    void process(float* dest, int numSamples);
+
+    /**
+     control rate output: the value now, then steps the phase over numSamples
+     without computing the samples in between
+
+     @param numSamples samples until the next control tick
+     @returns the value at the start of those samples
+     */
+    float advance(int numSamples);
+
+private:
+    //==========================================================================
+    /** @returns the waveform at phase p */
+    float valueAt(uint32_t p) const;
+    /** steps the phase by numSamples, drawing a new held value on each wrap */
+    void step(uint64_t numSamples);
+    //==========================================================================
+    double sampleRate = 44100;
+    double frequency = 1;
+    /** phase and its increment per sample, 2^32 to a cycle */
+    uint32_t phase = 0, increment = 0;
+    Shape shape = Shape::sine;
+    /** sample and hold value, and where it comes from */
+    float held = 0;
+    BlockNoise random;
+};
+
+#endif /* BlockLFO_hpp */
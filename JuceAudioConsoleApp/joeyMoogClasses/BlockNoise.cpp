@@ -0,0 +1,224 @@
+#include "BlockNoise.hpp"
+#include "LadderSIMD.hpp"
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+    /** splitmix64, spreads a seed over the generator state */
+    uint64_t splitMix(uint64_t& x)
+    {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27))*0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    //==========================================================================
+    /**
+     four lanes of xoshiro128+. Compilers do not reliably vectorise the
+     generator from plain arrays, so it is written out per instruction set
+     like LadderVec; every x86 target LadderSIMD picks has SSE2.
+     */
+    struct NoiseLanes
+    {
+#if LADDER_SIMD_AVX || LADDER_SIMD_SSE
+        __m128i a, b, c, d;
+
+        inline void load(const uint32_t* s0, const uint32_t* s1, const uint32_t* s2, const uint32_t* s3)
+        {
+            a = _mm_loadu_si128((const __m128i*) s0);
+            b = _mm_loadu_si128((const __m128i*) s1);
+            c = _mm_loadu_si128((const __m128i*) s2);
+            d = _mm_loadu_si128((const __m128i*) s3);
+        }
+
+        inline void store(uint32_t* s0, uint32_t* s1, uint32_t* s2, uint32_t* s3) const
+        {
+            _mm_storeu_si128((__m128i*) s0, a);
+            _mm_storeu_si128((__m128i*) s1, b);
+            _mm_storeu_si128((__m128i*) s2, c);
+            _mm_storeu_si128((__m128i*) s3, d);
+        }
+
+        /** steps each lane, writing four floats in [-0.5, 0.5) */
+        inline void next(float* dest)
+        {
+            const __m128i result = _mm_add_epi32(a, d);
+            const __m128i t = _mm_slli_epi32(b, 9);
+            c = _mm_xor_si128(c, a);
+            d = _mm_xor_si128(d, b);
+            b = _mm_xor_si128(b, c);
+            a = _mm_xor_si128(a, d);
+            c = _mm_xor_si128(c, t);
+            d = _mm_or_si128(_mm_slli_epi32(d, 11), _mm_srli_epi32(d, 21));
+
+            // top 23 bits as the mantissa of a float in [1, 2)
+            const __m128i bits = _mm_or_si128(_mm_srli_epi32(result, 9), _mm_set1_epi32(0x3f800000));
+            _mm_storeu_ps(dest, _mm_sub_ps(_mm_castsi128_ps(bits), _mm_set1_ps(1.5f)));
+        }
+#elif LADDER_SIMD_NEON
+        uint32x4_t a, b, c, d;
+
+        inline void load(const uint32_t* s0, const uint32_t* s1, const uint32_t* s2, const uint32_t* s3)
+        {
+            a = vld1q_u32(s0);
+            b = vld1q_u32(s1);
+            c = vld1q_u32(s2);
+            d = vld1q_u32(s3);
+        }
+
+        inline void store(uint32_t* s0, uint32_t* s1, uint32_t* s2, uint32_t* s3) const
+        {
+            vst1q_u32(s0, a);
+            vst1q_u32(s1, b);
+            vst1q_u32(s2, c);
+            vst1q_u32(s3, d);
+        }
+
+        /** steps each lane, writing four floats in [-0.5, 0.5) */
+        inline void next(float* dest)
+        {
+            const uint32x4_t result = vaddq_u32(a, d);
+            const uint32x4_t t = vshlq_n_u32(b, 9);
+            c = veorq_u32(c, a);
+            d = veorq_u32(d, b);
+            b = veorq_u32(b, c);
+            a = veorq_u32(a, d);
+            c = veorq_u32(c, t);
+            d = vorrq_u32(vshlq_n_u32(d, 11), vshrq_n_u32(d, 21));
+
+            // top 23 bits as the mantissa of a float in [1, 2)
+            const uint32x4_t bits = vorrq_u32(vshrq_n_u32(result, 9), vdupq_n_u32(0x3f800000));
+            vst1q_f32(dest, vsubq_f32(vreinterpretq_f32_u32(bits), vdupq_n_f32(1.5f)));
+        }
+#else
+        uint32_t a[4], b[4], c[4], d[4];
+
+        inline void load(const uint32_t* s0, const uint32_t* s1, const uint32_t* s2, const uint32_t* s3)
+        {
+            std::copy(s0, s0+4, a);
+            std::copy(s1, s1+4, b);
+            std::copy(s2, s2+4, c);
+            std::copy(s3, s3+4, d);
+        }
+
+        inline void store(uint32_t* s0, uint32_t* s1, uint32_t* s2, uint32_t* s3) const
+        {
+            std::copy(a, a+4, s0);
+            std::copy(b, b+4, s1);
+            std::copy(c, c+4, s2);
+            std::copy(d, d+4, s3);
+        }
+
+        /** steps each lane, writing four floats in [-0.5, 0.5) */
+        inline void next(float* dest)
+        {
+            for (int lane = 0; lane < 4; lane++)
+            {
+                const uint32_t result = a[lane] + d[lane];
+                const uint32_t t = b[lane] << 9;
+                c[lane] ^= a[lane];
+                d[lane] ^= b[lane];
+                b[lane] ^= c[lane];
+                a[lane] ^= d[lane];
+                c[lane] ^= t;
+                d[lane] = (d[lane] << 11) | (d[lane] >> 21);
+
+                // top 23 bits as the mantissa of a float in [1, 2)
+                const uint32_t bits = (result >> 9) | 0x3f800000u;
+                float f;
+                memcpy(&f, &bits, sizeof(f));
+                dest[lane] = f - 1.5f;
+            }
+        }
+#endif
+    };
+}
+//==============================================================================
+void BlockNoise::setSeed(uint64_t seed)
+{
+    for (int lane = 0; lane < numLanes; lane++)
+    {
+        const uint64_t a = splitMix(seed), b = splitMix(seed);
+        s0[lane] = (uint32_t) a;
+        s1[lane] = (uint32_t) (a >> 32);
+        s2[lane] = (uint32_t) b;
+        s3[lane] = (uint32_t) (b >> 32);
+
+        // xoshiro must not start from all zeros
+        if ((s0[lane] | s1[lane] | s2[lane] | s3[lane]) == 0)
+            s0[lane] = 1;
+    }
+
+    cacheRead = numLanes;
+    pink0 = pink1 = pink2 = brown = 0;
+}
+//==============================================================================
+void BlockNoise::fill(float* dest, const int numSamples)
+{
+    int n = 0;
+
+    // finish what the last call left over, then whole steps straight into
+    // dest, then one more step into the cache for the tail
+    const int fromCache = std::min(numSamples, numLanes - cacheRead);
+    for (; n < fromCache; n++)
+        dest[n] = cache[cacheRead++];
+
+    const int numSteps = (numSamples - n)/numLanes;
+    generate(dest + n, numSteps);
+    n += numSteps*numLanes;
+
+    if (n < numSamples)
+    {
+        generate(cache, 1);
+        cacheRead = 0;
+        for (; n < numSamples; n++)
+            dest[n] = cache[cacheRead++];
+    }
+
+    if (colour != Colour::white)
+        applyColour(dest, numSamples);
+}
+
+void BlockNoise::generate(float* dest, const int numSteps)
+{
+    // two independent groups of four lanes, so one can issue while the other waits
+    NoiseLanes low, high;
+    low.load(s0, s1, s2, s3);
+    high.load(s0+4, s1+4, s2+4, s3+4);
+
+    for (int step = 0; step < numSteps; step++)
+    {
+        low.next(dest + step*numLanes);
+        high.next(dest + step*numLanes + 4);
+    }
+
+    low.store(s0, s1, s2, s3);
+    high.store(s0+4, s1+4, s2+4, s3+4);
+}
+
+void BlockNoise::applyColour(float* samples, const int numSamples)
+{
+    if (colour == Colour::pink)
+    {
+        // Kellet's economy pink filter, gain matched to the white input
+        for (int n = 0; n < numSamples; n++)
+        {
+            const float white = samples[n];
+            pink0 = 0.99765f*pink0 + white*0.0990460f;
+            pink1 = 0.96300f*pink1 + white*0.2965164f;
+            pink2 = 0.57000f*pink2 + white*1.0526913f;
+            samples[n] = 0.332f*(pink0 + pink1 + pink2 + white*0.1848f);
+        }
+    }
+    else
+    {
+        // one pole at about 20 Hz at 48 kHz, gain matched to the white input
+        for (int n = 0; n < numSamples; n++)
+        {
+            brown = 0.9974f*brown + samples[n];
+            samples[n] = 0.072f*brown;
+        }
+    }
+}
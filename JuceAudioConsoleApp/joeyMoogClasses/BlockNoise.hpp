@@ -0,0 +1,90 @@
+//
+//  BlockNoise.hpp
+//
+//  Seeded noise source that fills whole buffers at a time, for exciting the
+//  ladder filters. White, pink or brown.
+//
+
+#ifndef BlockNoise_hpp
+#define BlockNoise_hpp
+
+#include <cstdint>
+
+/**
+ BlockNoise class: numLanes xoshiro128+ generators run side by side, lane i
+ giving every numLanes'th sample. Each step is the same shifts, xors and adds
+ on every lane, done four lanes to an SSE2 or NEON register, and the top 23
+ bits of each result become a float in [-0.5, 0.5) without a divide.
+
+ The stream depends only on the seed: not on the block sizes it is read in,
+ nor on the machine, since everything up to the float is integer arithmetic.
+ Pink and brown are filtered from the white stream, keeping its RMS of about
+ 0.29.
+ */
+class BlockNoise
+{
+public:
+    //==========================================================================
+    /** spectrum of the noise */
+    enum class Colour
+    {
+        white,  /**< flat */
+        pink,   /**< -3 dB per octave, Paul Kellet's three pole filter */
+        brown   /**< -6 dB per octave above 20 Hz, a leaky integrator */
+    };
+
+    /** generators run side by side */
+    static const int numLanes = 8;
+    //==========================================================================
+    /** Constructor */
+    BlockNoise(uint64_t seed = 1)
+    {
+        setSeed(seed);
+    };
+    /** Destructor */
+    ~BlockNoise(){};
+    //==========================================================================
+    /**
+     restarts the stream. The same seed always gives the same samples.
+
+     @param seed any value, including 0
+     */
+    void setSeed(uint64_t seed);
+
+    /**
+     sets the spectrum. The pink and brown filters keep their state, so this
+     can be changed between blocks without a click.
+
+     @param newColour spectrum of the following samples
+     */
+    void setColour(Colour newColour) { colour = newColour; }
+
+    /** @returns the spectrum in use */
+    Colour getColour() const { return colour; }
+    //==========================================================================
+    /**
+     writes the next numSamples samples of the stream
+
+     @param dest buffer of numSamples
+     @param numSamples number of samples, any size
+     */
+    void fill(float* dest, int numSamples);
+
+private:
+    //==========================================================================
+    /** steps every lane numSteps times, writing numSteps*numLanes white samples */
+    void generate(float* dest, int numSteps);
+    /** filters white samples in place into the current colour */
+    void applyColour(float* samples, int numSamples);
+    //==========================================================================
+    /** xoshiro128+ state, one word of each lane per array */
+    uint32_t s0[numLanes], s1[numLanes], s2[numLanes], s3[numLanes];
+    /** samples generated but not read yet, from cache[cacheRead] */
+    float cache[numLanes];
+    int cacheRead = numLanes;
+    Colour colour = Colour::white;
+    /** pink filter poles and brown integrator */
+    float pink0 = 0, pink1 = 0, pink2 = 0, brown = 0;
+};
+
+#endif /* BlockNoise_hpp */
@@ -0,0 +1,20 @@
+#include "LadderCutoff.hpp"
+
+namespace
+{
+    /** fills the CutoffToW0 table before main() runs */
+    struct Pow2Table
+    {
+        Pow2Table()
+        {
+            for (int i = 0; i <= CutoffToW0::size; i++)
+                values[i] = pow(2.0, i/(double)CutoffToW0::size);
+        }
+
+        double values[CutoffToW0::size+1];
+    };
+
+    const Pow2Table pow2Table;
+}
+
+const double* const CutoffToW0::table = pow2Table.values;
@@ -0,0 +1,37 @@
+//
+//  LadderCutoff.hpp
+//
+//  Cutoff side chain to angular cutoff frequency mapping shared by the
+//  ladder filters, w0 = 2*pi*20*2^(10*cutoff), without a pow call.
+//
+
+#ifndef LadderCutoff_hpp
+#define LadderCutoff_hpp
+
+#include <cmath>
+
+/**
+ 2^(10*cutoff) is split into a whole power of two, applied with ldexp, and
+ 2^frac for frac in [0,1), read from a 1024 interval table with linear
+ interpolation. Max relative error 5.7e-8 (h^2/8*ln(2)^2).
+ */
+struct CutoffToW0
+{
+    /** number of intervals in the table */
+    static const int size = 1024;
+    /** 2^(i/size) for i in [0, size] */
+    static const double* const table;
+
+    static inline double process(double cutoff)
+    {
+        const double octaves = 10*cutoff;
+        const double whole = floor(octaves);
+        const double pos = (octaves - whole)*size;
+        const int i = (int) pos;
+        const double frac = pos - i;
+        const double pow2frac = table[i] + frac*(table[i+1] - table[i]);
+        return 2*3.1415926536*20*ldexp(pow2frac, (int) whole);
+    }
+};
+
+#endif /* LadderCutoff_hpp */
@@ -0,0 +1,106 @@
+//
+//  LadderDenormals.hpp
+//
+//  Keeps subnormal numbers out of the ladder filters: a scope that has the
+//  FPU flush them to zero, and the level the filters zero their own state at.
+//
+
+#ifndef LadderDenormals_hpp
+#define LadderDenormals_hpp
+
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <xmmintrin.h>
+ #define LADDER_FTZ_SSE 1
+#elif defined(__aarch64__)
+ #define LADDER_FTZ_AARCH64 1
+#elif defined(__arm__) && defined(__VFP_FP__) && ! defined(__SOFTFP__)
+ #define LADDER_FTZ_VFP 1
+#endif
+
+/**
+ state magnitude below which the ladders zero it, about -300 dB: far under
+ the noise floor of any output and far above the subnormals, which start at
+ 1e-38 in float. Once zeroed, silence in keeps the state exactly zero.
+ */
+const double ladderFlushThreshold = 1.0e-15;
+
+/**
+ ScopedFlushDenormals class: while in scope, the calling thread's FPU treats
+ subnormal inputs as zero and flushes subnormal results to zero, so a decaying
+ tail cannot drop onto the slow microcoded paths some CPUs take for them.
+ Restores the previous mode when it goes out of scope.
+
+ The mode belongs to the thread, so every thread running filters needs its
+ own scope. Uses MXCSR FTZ and DAZ on x86, FPCR FZ on AArch64 and FPSCR FZ on
+ 32 bit ARM with a hardware FPU (NEON always flushes); elsewhere it does
+ nothing, and the ladders' own state flushing is all there is.
+ */
+class ScopedFlushDenormals
+{
+public:
+    //==========================================================================
+    ScopedFlushDenormals() noexcept : previous(getMode())
+    {
+        setMode(previous | flushBits);
+    }
+
+    ~ScopedFlushDenormals() noexcept
+    {
+        setMode(previous);
+    }
+    //==========================================================================
+    /** @returns true if the scope changes anything on this build */
+    static bool isSupported() { return flushBits != 0; }
+
+private:
+    //==========================================================================
+#if LADDER_FTZ_SSE
+    typedef unsigned int Mode;
+    /** MXCSR flush to zero and denormals are zero */
+    static const Mode flushBits = 0x8040;
+
+    static Mode getMode() noexcept { return _mm_getcsr(); }
+    static void setMode(Mode mode) noexcept { _mm_setcsr(mode); }
+#elif LADDER_FTZ_AARCH64
+    typedef uint64_t Mode;
+    /** FPCR FZ */
+    static const Mode flushBits = 1 << 24;
+
+    static Mode getMode() noexcept
+    {
+        Mode mode;
+        __asm__ __volatile__ ("mrs %0, fpcr" : "=r" (mode));
+        return mode;
+    }
+
+    static void setMode(Mode mode) noexcept { __asm__ __volatile__ ("msr fpcr, %0" : : "r" (mode)); }
+#elif LADDER_FTZ_VFP
+    typedef uint32_t Mode;
+    /** FPSCR FZ */
+    static const Mode flushBits = 1 << 24;
+
+    static Mode getMode() noexcept
+    {
+        Mode mode;
+        __asm__ __volatile__ ("vmrs %0, fpscr" : "=r" (mode));
+        return mode;
+    }
+
+    static void setMode(Mode mode) noexcept { __asm__ __volatile__ ("vmsr fpscr, %0" : : "r" (mode)); }
+#else
+    typedef unsigned int Mode;
+    static const Mode flushBits = 0;
+
+    static Mode getMode() noexcept { return 0; }
+    static void setMode(Mode) noexcept {}
+#endif
+    //==========================================================================
+    const Mode previous;
+
+    ScopedFlushDenormals(const ScopedFlushDenormals&) = delete;
+    ScopedFlushDenormals& operator=(const ScopedFlushDenormals&) = delete;
+};
+
+#endif /* LadderDenormals_hpp */
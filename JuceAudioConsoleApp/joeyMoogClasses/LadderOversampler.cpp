@@ -0,0 +1,198 @@
+#include "LadderOversampler.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    /** taps per side and Kaiser beta for each stage from the base rate up. The
+        first stage has to keep the whole base band (to 0.42 of its rate) and
+        stop its image; the later ones have the rest of their band to roll off
+        in. Images of the base band are at least 80 dB down at every factor. */
+    const int stageTaps[3]    = { 16, 6, 6 };
+    const double stageBeta[3] = { 8.0, 8.0, 8.0 };
+
+    /** zeroth order modified Bessel function of the first kind, for the window */
+    double besselI0(double x)
+    {
+        double sum = 1, term = 1;
+        for (int k = 1; k < 32; k++)
+        {
+            term *= (x/(2*k))*(x/(2*k));
+            sum += term;
+        }
+        return sum;
+    }
+}
+//==============================================================================
+void LadderOversampler::init(const int maxFactor, const int extMaxBlockSize)
+{
+    int maxStages = 0;
+    while ((1 << maxStages) < maxFactor && maxStages < 3)
+        maxStages++;
+
+    maxBlockSize = extMaxBlockSize;
+    stages.assign(maxStages, Stage());
+    // at 1x the first buffer holds the block the caller processes
+    buffers.assign(std::max(maxStages, 1), std::vector<float>(maxBlockSize, 0.0f));
+
+    for (int i = 0; i < maxStages; i++)
+    {
+        Stage& stage = stages[i];
+        designStage(stage, stageTaps[i], stageBeta[i]);
+
+        // stage i runs at 2^i times the base rate on its input side
+        const int stageBlock = maxBlockSize << i;
+        stage.upHistory.assign(2*stage.numTaps-1 + stageBlock, 0.0f);
+        stage.downEven.assign(2*stage.numTaps-1 + stageBlock, 0.0f);
+        stage.downOdd.assign(stage.numTaps + stageBlock, 0.0f);
+        buffers[i].assign(2*stageBlock, 0.0f);
+    }
+
+    numStagesInUse = maxStages;
+}
+
+void LadderOversampler::setFactor(const int factor)
+{
+    int numStages = 0;
+    while ((1 << numStages) < factor && numStages < (int) stages.size())
+        numStages++;
+
+    numStagesInUse = numStages;
+    reset();
+}
+
+double LadderOversampler::getLatencyInSamples() const
+{
+    // each stage delays by its centre tap 2K-1 going up and again coming down,
+    // at twice its input rate: 2K-1 samples at its input rate
+    double latency = 0;
+    for (int i = 0; i < numStagesInUse; i++)
+        latency += (2*stages[i].numTaps-1)/(double)(1 << i);
+    return latency;
+}
+
+void LadderOversampler::reset()
+{
+    for (Stage& stage : stages)
+    {
+        std::fill(stage.upHistory.begin(), stage.upHistory.end(), 0.0f);
+        std::fill(stage.downEven.begin(), stage.downEven.end(), 0.0f);
+        std::fill(stage.downOdd.begin(), stage.downOdd.end(), 0.0f);
+    }
+}
+//==============================================================================
+float* LadderOversampler::upsample(const float* in, const int numSamples)
+{
+    if (numStagesInUse == 0)
+    {
+        // nothing to do at 1x: hand back a copy the caller may process in place
+        std::copy(in, in+numSamples, buffers[0].begin());
+        return buffers[0].data();
+    }
+
+    const float* stageIn = in;
+    for (int i = 0; i < numStagesInUse; i++)
+    {
+        upsampleStage(stages[i], stageIn, buffers[i].data(), numSamples << i);
+        stageIn = buffers[i].data();
+    }
+    return buffers[numStagesInUse-1].data();
+}
+
+void LadderOversampler::downsample(float* out, const int numSamples)
+{
+    if (numStagesInUse == 0)
+    {
+        std::copy(buffers[0].begin(), buffers[0].begin()+numSamples, out);
+        return;
+    }
+
+    for (int i = numStagesInUse-1; i >= 0; i--)
+    {
+        float* stageOut = i > 0 ? buffers[i-1].data() : out;
+        downsampleStage(stages[i], buffers[i].data(), stageOut, numSamples << i);
+    }
+}
+//==============================================================================
+void LadderOversampler::designStage(Stage& stage, const int numTaps, const double beta)
+{
+    // h[n] = sinc((n-c)/2)/2 windowed, c = 2K-1; only the even n are kept
+    const int length = 4*numTaps-1;
+    const int centre = 2*numTaps-1;
+    const double pi = 3.1415926536;
+
+    stage.numTaps = numTaps;
+    stage.taps.assign(numTaps, 0.0f);
+
+    for (int j = 0; j < numTaps; j++)
+    {
+        const int n = 2*j;
+        const double t = (n - centre)*0.5;
+        const double sinc = std::sin(pi*t)/(pi*t);
+        const double ratio = (2.0*n)/(length-1) - 1.0;
+        const double window = besselI0(beta*std::sqrt(1.0 - ratio*ratio))/besselI0(beta);
+        stage.taps[j] = (float) (0.5*sinc*window);
+    }
+
+    // normalise so the even taps sum to 1/2 and the DC gain is exactly 1
+    double sum = 0;
+    for (int j = 0; j < numTaps; j++)
+        sum += 2*stage.taps[j];
+    for (int j = 0; j < numTaps; j++)
+        stage.taps[j] = (float) (stage.taps[j]*0.5/sum);
+}
+
+void LadderOversampler::upsampleStage(Stage& stage, const float* in, float* out, const int numSamples)
+{
+    // y[2m] = 2*sum h[2j]*x[m-j], y[2m+1] = x[m-(K-1)]
+    const int K = stage.numTaps;
+    const int history = 2*K-1;
+    float* x = stage.upHistory.data();
+    const float* h = stage.taps.data();
+
+    std::copy(in, in+numSamples, x+history);
+
+    for (int m = 0; m < numSamples; m++)
+    {
+        const float* newest = x + history + m;
+        const float* oldest = newest - (2*K-1);
+        float sum = 0;
+        for (int j = 0; j < K; j++)
+            sum += h[j]*(newest[-j] + oldest[j]);
+
+        out[2*m]   = 2*sum;
+        out[2*m+1] = newest[-(K-1)];
+    }
+
+    std::copy(x+numSamples, x+numSamples+history, x);
+}
+
+void LadderOversampler::downsampleStage(Stage& stage, const float* in, float* out, const int numSamples)
+{
+    // z[m] = sum h[2j]*v[2(m-j)] + v[2(m-K)+1]/2
+    const int K = stage.numTaps;
+    const int evenHistory = 2*K-1;
+    float* even = stage.downEven.data();
+    float* odd = stage.downOdd.data();
+    const float* h = stage.taps.data();
+
+    for (int m = 0; m < numSamples; m++)
+    {
+        even[evenHistory+m] = in[2*m];
+        odd[K+m] = in[2*m+1];
+    }
+
+    for (int m = 0; m < numSamples; m++)
+    {
+        const float* newest = even + evenHistory + m;
+        const float* oldest = newest - (2*K-1);
+        float sum = 0;
+        for (int j = 0; j < K; j++)
+            sum += h[j]*(newest[-j] + oldest[j]);
+
+        out[m] = sum + 0.5f*odd[m];
+    }
+
+    std::copy(even+numSamples, even+numSamples+evenHistory, even);
+    std::copy(odd+numSamples, odd+numSamples+K, odd);
+}
@@ -0,0 +1,133 @@
+//
+//  LadderOversampler.hpp
+//
+//  2x, 4x and 8x oversampling from cascaded halfband FIR stages, each run in
+//  polyphase form so only the non-zero taps are computed.
+//
+
+#ifndef LadderOversampler_hpp
+#define LadderOversampler_hpp
+
+#include <vector>
+
+/**
+ LadderOversampler class: upsamples a block to factor times the rate, lets the
+ caller process it there, and brings it back down. Every 2x stage is a linear
+ phase halfband FIR: half its taps are zero and the other phase is the centre
+ tap alone, so each stage costs one symmetric K tap sum per output pair.
+ All buffers are allocated by init(); setFactor(), upsample() and downsample()
+ do not allocate.
+ */
+class LadderOversampler
+{
+public:
+    //==========================================================================
+    /** Constructor */
+    LadderOversampler(){};
+    /** Destructor */
+    ~LadderOversampler(){};
+    //==========================================================================
+    /**
+     allocates the stages and buffers. Not real time safe.
+
+     @param maxFactor largest factor setFactor() will be asked for: 1, 2, 4 or 8
+     @param maxBlockSize largest block passed to upsample() and downsample()
+     */
+    void init(int maxFactor, int maxBlockSize);
+
+    /**
+     sets the oversampling factor and clears the filter histories
+
+     @param factor 1, 2, 4 or 8, no more than the maxFactor given to init()
+     */
+    void setFactor(int factor);
+
+    /** @returns the oversampling factor in use */
+    int getFactor() const { return 1 << numStagesInUse; }
+
+    /** @returns the delay added by upsample() then downsample(), in samples at
+        the base rate. Not a whole number for factors above 2 */
+    double getLatencyInSamples() const;
+
+    /**
+     upsamples a block
+
+     @param in numSamples samples at the base rate
+     @param numSamples number of samples, no more than maxBlockSize
+     @returns numSamples*getFactor() samples at the oversampled rate, valid until
+              the next call. May be processed in place before downsample()
+     */
+    float* upsample(const float* in, int numSamples);
+
+    /**
+     downsamples the block returned by the last upsample()
+
+     @param out numSamples samples at the base rate
+     @param numSamples the same number of samples as given to upsample()
+     */
+    void downsample(float* out, int numSamples);
+
+    /** clears the filter histories */
+    void reset();
+
+private:
+    //==========================================================================
+    /**
+     One 2x halfband stage. With K taps per side the filter is 4K-1 long,
+     centred on tap 2K-1; the even taps h[2j] are symmetric and the odd ones
+     are zero apart from the centre, which is 1/2.
+     */
+    struct Stage
+    {
+        /** number of distinct even taps */
+        int numTaps = 0;
+        /** h[2j] for j in [0, numTaps), the other half mirrors these */
+        std::vector<float> taps;
+        /** last 2K-1 inputs to the up filter followed by the current block */
+        std::vector<float> upHistory;
+        /** last 2K-1 even inputs to the down filter followed by the current block */
+        std::vector<float> downEven;
+        /** last K odd inputs to the down filter followed by the current block */
+        std::vector<float> downOdd;
+    };
+    //==========================================================================
+    /**
+     fills the even taps of a Kaiser windowed halfband lowpass
+
+     @param stage stage to fill
+     @param numTaps K, the number of distinct even taps
+     @param beta Kaiser window shape
+     */
+    static void designStage(Stage& stage, int numTaps, double beta);
+
+    /**
+     2x upsamples in into out through one stage
+
+     @param stage stage to run
+     @param in numSamples input samples
+     @param out 2*numSamples output samples
+     @param numSamples number of input samples
+     */
+    static void upsampleStage(Stage& stage, const float* in, float* out, int numSamples);
+
+    /**
+     2x downsamples in into out through one stage
+
+     @param stage stage to run
+     @param in 2*numSamples input samples
+     @param out numSamples output samples
+     @param numSamples number of output samples
+     */
+    static void downsampleStage(Stage& stage, const float* in, float* out, int numSamples);
+    //==========================================================================
+    /** stages from the base rate upwards */
+    std::vector<Stage> stages;
+    /** number of stages used for the current factor */
+    int numStagesInUse = 0;
+    /** largest block at the base rate */
+    int maxBlockSize = 0;
+    /** one buffer per rate above the base rate, buffers[i] at 2^(i+1) times */
+    std::vector<std::vector<float>> buffers;
+};
+
+#endif /* LadderOversampler_hpp */
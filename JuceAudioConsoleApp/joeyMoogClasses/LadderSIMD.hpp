@@ -0,0 +1,160 @@
+//
+//  LadderSIMD.hpp
+//
+//  Float vector type used to run several ladder filters side by side.
+//  Picks AVX (8 lanes), SSE2 or NEON (4 lanes) from the compiler flags and
+//  falls back to plain arrays of 4 floats otherwise.
+//
+
+#ifndef LadderSIMD_hpp
+#define LadderSIMD_hpp
+
+#if defined(__AVX__)
+ #include <immintrin.h>
+ #define LADDER_SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define LADDER_SIMD_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #include <arm_neon.h>
+ #define LADDER_SIMD_NEON 1
+#endif
+
+/**
+ A handful of floats processed together. Only the operations the ladder
+ kernels need are provided.
+ */
+struct LadderVec
+{
+    //==========================================================================
+#if LADDER_SIMD_AVX
+    typedef __m256 Native;
+    static const int width = 8;
+#elif LADDER_SIMD_SSE
+    typedef __m128 Native;
+    static const int width = 4;
+#elif LADDER_SIMD_NEON
+    typedef float32x4_t Native;
+    static const int width = 4;
+#else
+    struct Native { float lane[4]; };
+    static const int width = 4;
+#endif
+
+    Native v;
+    //==========================================================================
+    /** loads width floats, no alignment needed */
+    static inline LadderVec load(const float* p)
+    {
+#if LADDER_SIMD_AVX
+        return { _mm256_loadu_ps(p) };
+#elif LADDER_SIMD_SSE
+        return { _mm_loadu_ps(p) };
+#elif LADDER_SIMD_NEON
+        return { vld1q_f32(p) };
+#else
+        LadderVec r;
+        for (int i = 0; i < width; i++) r.v.lane[i] = p[i];
+        return r;
+#endif
+    }
+
+    /** stores width floats, no alignment needed */
+    inline void store(float* p) const
+    {
+#if LADDER_SIMD_AVX
+        _mm256_storeu_ps(p, v);
+#elif LADDER_SIMD_SSE
+        _mm_storeu_ps(p, v);
+#elif LADDER_SIMD_NEON
+        vst1q_f32(p, v);
+#else
+        for (int i = 0; i < width; i++) p[i] = v.lane[i];
+#endif
+    }
+
+    /** all lanes set to f */
+    static inline LadderVec fill(float f)
+    {
+#if LADDER_SIMD_AVX
+        return { _mm256_set1_ps(f) };
+#elif LADDER_SIMD_SSE
+        return { _mm_set1_ps(f) };
+#elif LADDER_SIMD_NEON
+        return { vdupq_n_f32(f) };
+#else
+        LadderVec r;
+        for (int i = 0; i < width; i++) r.v.lane[i] = f;
+        return r;
+#endif
+    }
+};
+
+//==============================================================================
+#if LADDER_SIMD_AVX
+inline LadderVec operator+ (LadderVec a, LadderVec b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline LadderVec operator- (LadderVec a, LadderVec b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline LadderVec operator* (LadderVec a, LadderVec b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline LadderVec operator/ (LadderVec a, LadderVec b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline LadderVec min (LadderVec a, LadderVec b)       { return { _mm256_min_ps(a.v, b.v) }; }
+inline LadderVec max (LadderVec a, LadderVec b)       { return { _mm256_max_ps(a.v, b.v) }; }
+/** lanes of a that are not zero take ifNonZero, the rest take ifZero */
+inline LadderVec selectNonZero (LadderVec a, LadderVec ifNonZero, LadderVec ifZero)
+{
+    const __m256 isZero = _mm256_cmp_ps(a.v, _mm256_setzero_ps(), _CMP_EQ_OQ);
+    return { _mm256_blendv_ps(ifNonZero.v, ifZero.v, isZero) };
+}
+#elif LADDER_SIMD_SSE
+inline LadderVec operator+ (LadderVec a, LadderVec b) { return { _mm_add_ps(a.v, b.v) }; }
+inline LadderVec operator- (LadderVec a, LadderVec b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline LadderVec operator* (LadderVec a, LadderVec b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline LadderVec operator/ (LadderVec a, LadderVec b) { return { _mm_div_ps(a.v, b.v) }; }
+inline LadderVec min (LadderVec a, LadderVec b)       { return { _mm_min_ps(a.v, b.v) }; }
+inline LadderVec max (LadderVec a, LadderVec b)       { return { _mm_max_ps(a.v, b.v) }; }
+/** lanes of a that are not zero take ifNonZero, the rest take ifZero */
+inline LadderVec selectNonZero (LadderVec a, LadderVec ifNonZero, LadderVec ifZero)
+{
+    const __m128 isZero = _mm_cmpeq_ps(a.v, _mm_setzero_ps());
+    return { _mm_or_ps(_mm_and_ps(isZero, ifZero.v), _mm_andnot_ps(isZero, ifNonZero.v)) };
+}
+#elif LADDER_SIMD_NEON
+inline LadderVec operator+ (LadderVec a, LadderVec b) { return { vaddq_f32(a.v, b.v) }; }
+inline LadderVec operator- (LadderVec a, LadderVec b) { return { vsubq_f32(a.v, b.v) }; }
+inline LadderVec operator* (LadderVec a, LadderVec b) { return { vmulq_f32(a.v, b.v) }; }
+inline LadderVec operator/ (LadderVec a, LadderVec b)
+{
+ #if defined(__aarch64__)
+    return { vdivq_f32(a.v, b.v) };
+ #else
+    // ARMv7 NEON has no divide: reciprocal estimate refined by two Newton steps
+    float32x4_t recip = vrecpeq_f32(b.v);
+    recip = vmulq_f32(vrecpsq_f32(b.v, recip), recip);
+    recip = vmulq_f32(vrecpsq_f32(b.v, recip), recip);
+    return { vmulq_f32(a.v, recip) };
+ #endif
+}
+inline LadderVec min (LadderVec a, LadderVec b)       { return { vminq_f32(a.v, b.v) }; }
+inline LadderVec max (LadderVec a, LadderVec b)       { return { vmaxq_f32(a.v, b.v) }; }
+/** lanes of a that are not zero take ifNonZero, the rest take ifZero */
+inline LadderVec selectNonZero (LadderVec a, LadderVec ifNonZero, LadderVec ifZero)
+{
+    const uint32x4_t isZero = vceqq_f32(a.v, vdupq_n_f32(0.0f));
+    return { vbslq_f32(isZero, ifZero.v, ifNonZero.v) };
+}
+#else
+#define LADDER_VEC_LANEWISE(expr) LadderVec r; for (int i = 0; i < LadderVec::width; i++) r.v.lane[i] = (expr); return r;
+inline LadderVec operator+ (LadderVec a, LadderVec b) { LADDER_VEC_LANEWISE(a.v.lane[i] + b.v.lane[i]) }
+inline LadderVec operator- (LadderVec a, LadderVec b) { LADDER_VEC_LANEWISE(a.v.lane[i] - b.v.lane[i]) }
+inline LadderVec operator* (LadderVec a, LadderVec b) { LADDER_VEC_LANEWISE(a.v.lane[i] * b.v.lane[i]) }
+inline LadderVec operator/ (LadderVec a, LadderVec b) { LADDER_VEC_LANEWISE(a.v.lane[i] / b.v.lane[i]) }
+inline LadderVec min (LadderVec a, LadderVec b)       { LADDER_VEC_LANEWISE(a.v.lane[i] < b.v.lane[i] ? a.v.lane[i] : b.v.lane[i]) }
+inline LadderVec max (LadderVec a, LadderVec b)       { LADDER_VEC_LANEWISE(a.v.lane[i] > b.v.lane[i] ? a.v.lane[i] : b.v.lane[i]) }
+/** lanes of a that are not zero take ifNonZero, the rest take ifZero */
+inline LadderVec selectNonZero (LadderVec a, LadderVec ifNonZero, LadderVec ifZero)
+{
+    LADDER_VEC_LANEWISE(a.v.lane[i] != 0.0f ? ifNonZero.v.lane[i] : ifZero.v.lane[i])
+}
+#undef LADDER_VEC_LANEWISE
+#endif
+
+#endif /* LadderSIMD_hpp */
@@ -0,0 +1,22 @@
+#include "LadderSaturation.hpp"
+
+namespace
+{
+    /** fills the TableTanh table before main() runs */
+    struct TanhTable
+    {
+        TanhTable()
+        {
+            for (int i = 0; i <= TableTanh::size; i++)
+                values[i] = (float) tanh(i/(double)TableTanh::perUnit);
+
+            values[TableTanh::size+1] = values[TableTanh::size];
+        }
+
+        float values[TableTanh::size+2];
+    };
+
+    const TanhTable tanhTable;
+}
+
+const float* const TableTanh::table = tanhTable.values;
@@ -0,0 +1,109 @@
+//
+//  LadderSaturation.hpp
+//
+//  tanh kernels for the nonlinear ladder, from exact to cheap. Each one is a
+//  struct with a static process() so a filter can take it as a template
+//  argument, and LadderSaturation names them for choosing per instance.
+//
+
+#ifndef LadderSaturation_hpp
+#define LadderSaturation_hpp
+
+#include <cmath>
+#include "LadderSIMD.hpp"
+
+/** saturation tiers that can be chosen per filter instance */
+enum class LadderSaturation
+{
+    exact,      /**< libm tanh */
+    rational,   /**< 7/6 rational approximation, max error 9.6e-5 */
+    table       /**< interpolated lookup table, max error 3.9e-7 */
+};
+
+/** compile time default for new filters, e.g. -DJOEY_MOOG_SATURATION=table */
+#ifndef JOEY_MOOG_SATURATION
+ #define JOEY_MOOG_SATURATION exact
+#endif
+
+//==============================================================================
+/**
+ libm tanh: the reference the other tiers are measured against
+ */
+struct ExactTanh
+{
+    static inline double process(double x) { return tanh(x); }
+    static inline float process(float x)   { return std::tanh(x); }
+};
+
+//==============================================================================
+/**
+ Lambert's continued fraction for tanh cut at 7/6, with the input clamped to
+ +-4.97 where the fraction reaches 1.
+ Max absolute error 9.6e-5 (at the clamp), exact at 0 and odd.
+ */
+struct RationalTanh
+{
+    static inline double process(double x)
+    {
+        x = x < -4.97 ? -4.97 : (x > 4.97 ? 4.97 : x);
+        const double x2 = x*x;
+        return x*(135135.0 + x2*(17325.0 + x2*(378.0 + x2)))
+                /(135135.0 + x2*(62370.0 + x2*(3150.0 + x2*28.0)));
+    }
+
+    static inline float process(float x)
+    {
+        x = x < -4.97f ? -4.97f : (x > 4.97f ? 4.97f : x);
+        const float x2 = x*x;
+        return x*(135135.0f + x2*(17325.0f + x2*(378.0f + x2)))
+                /(135135.0f + x2*(62370.0f + x2*(3150.0f + x2*28.0f)));
+    }
+
+    static inline LadderVec process(LadderVec in)
+    {
+        const LadderVec x  = min(max(in, LadderVec::fill(-4.97f)), LadderVec::fill(4.97f));
+        const LadderVec x2 = x*x;
+        const LadderVec num = LadderVec::fill(135135.0f) + x2*(LadderVec::fill(17325.0f) + x2*(LadderVec::fill(378.0f) + x2));
+        const LadderVec den = LadderVec::fill(135135.0f) + x2*(LadderVec::fill(62370.0f) + x2*(LadderVec::fill(3150.0f) + x2*LadderVec::fill(28.0f)));
+        return x*num/den;
+    }
+};
+
+//==============================================================================
+/**
+ tanh on [0, 8] sampled at 4096 intervals, linearly interpolated and mirrored
+ for negative input; tanh(8) beyond the table.
+ Max absolute error 3.9e-7: the interpolation bound h^2/8*max|tanh''| is 3.7e-7,
+ the rest is the float rounding of the entries.
+ */
+struct TableTanh
+{
+    /** number of intervals in the table */
+    static const int size = 4096;
+    /** table entries per unit input */
+    static const int perUnit = 512;
+    /** tanh(i/perUnit) for i in [0, size], plus a copy of the last entry */
+    static const float* const table;
+
+    static inline double process(double x)
+    {
+        const double ax = fabs(x);
+        const double pos = ax < size/(double)perUnit ? ax*perUnit : (double)size;
+        const int i = (int) pos;
+        const double frac = pos - i;
+        const double y = table[i] + frac*(table[i+1] - table[i]);
+        return x < 0 ? -y : y;
+    }
+
+    static inline float process(float x)
+    {
+        const float ax = std::fabs(x);
+        const float pos = ax < size/(float)perUnit ? ax*perUnit : (float)size;
+        const int i = (int) pos;
+        const float frac = pos - i;
+        const float y = table[i] + frac*(table[i+1] - table[i]);
+        return x < 0 ? -y : y;
+    }
+};
+
+#endif /* LadderSaturation_hpp */
@@ -0,0 +1,79 @@
+//
+//  LadderSolver.hpp
+//
+//  How the nonlinear ladder advances a sample: the one linear solve it has
+//  always used, or Newton's method on the implicit trapezoidal step, capped
+//  at a fixed number of iterations. Each one is a struct so a filter can take
+//  it as a template argument, and LadderSolver names them for choosing per
+//  instance.
+//
+
+#ifndef LadderSolver_hpp
+#define LadderSolver_hpp
+
+/**
+ solver tiers that can be chosen per filter instance. An iteration of the
+ implicit tiers costs poles+1 tanh and a substitution with poles divisions,
+ and the first one reuses the tanh of the previous state, so the cost of a
+ sample is bounded by the iteration cap whatever the input does.
+
+ Worst case, every sample run to the cap, for the four pole double ladder on
+ a 2.1 GHz Xeon, in cycles/sample with the exact and rational tanh tiers:
+ linearised 230 and 120, draft 360 and 220, standard 480 and 320, precise 930
+ and 620. Against a finely stepped reference of the ladder equations, draft
+ already takes the RMS error from 3-180% of the output to 0.005-14%, the rest
+ being the trapezoidal rule's own error at high cutoffs; the higher tiers
+ only tighten the convergence, and usually stop early.
+ */
+enum class LadderSolver
+{
+    linearised,         /**< one linear solve, with the tanh terms taken at the previous state */
+    implicitDraft,      /**< at most 2 Newton iterations, stops below 1e-4 */
+    implicitStandard,   /**< at most 3 Newton iterations, stops below 1e-6 */
+    implicitPrecise     /**< at most 6 Newton iterations, stops below 1e-9 */
+};
+
+/** compile time default for new filters, e.g. -DJOEY_MOOG_SOLVER=implicitStandard */
+#ifndef JOEY_MOOG_SOLVER
+ #define JOEY_MOOG_SOLVER linearised
+#endif
+
+//==============================================================================
+/**
+ the linearisation: rho, B and the saturated state are taken at the previous
+ sample and the step is one linear solve. Cheapest, but the tanh terms lag a
+ sample, which costs gain and tuning at high drive and resonance.
+ */
+struct LinearisedSolve
+{
+    static const int maxIterations = 0;
+    static inline double tolerance() { return 0; }
+};
+
+/**
+ Newton's method on the trapezoidal step of the ladder equations, started
+ from the previous sample's state. Stops once no state moves by more than
+ tolerance() in an iteration, and after maxIterations whatever happens.
+ */
+template <int MaxIterations>
+struct ImplicitSolve
+{
+    static const int maxIterations = MaxIterations;
+};
+
+struct ImplicitDraftSolve : ImplicitSolve<2>
+{
+    static inline double tolerance() { return 1.0e-4; }
+};
+
+struct ImplicitStandardSolve : ImplicitSolve<3>
+{
+    static inline double tolerance() { return 1.0e-6; }
+};
+
+struct ImplicitPreciseSolve : ImplicitSolve<6>
+{
+    static inline double tolerance() { return 1.0e-9; }
+};
+
+#endif /* LadderSolver_hpp */
@@ -0,0 +1,1024 @@
+//
+//  MoogLadder.hpp
+//
+//  Moog ladder filter templated on the sample type, on a policy that picks
+//  the linear or the nonlinear (tanh) model, and on the number of poles.
+//  JoeyMoogSC and JoeyNonLinearMoogSC are its double precision four pole
+//  instances.
+//
+
+#ifndef MoogLadder_hpp
+#define MoogLadder_hpp
+
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "LadderSaturation.hpp"
+#include "LadderSolver.hpp"
+#include "LadderCutoff.hpp"
+#include "LadderDenormals.hpp"
+
+//==============================================================================
+/** policy for the linear model: the state and input enter the update as they are */
+struct LinearLadder
+{
+    static const bool isLinear = true;
+};
+
+/** policy for the nonlinear model: the state and input are saturated by the
+    tanh tier chosen with MoogLadder::setSaturation(), and the step is solved
+    as chosen with MoogLadder::setSolver() */
+struct NonLinearLadder
+{
+    static const bool isLinear = false;
+};
+
+//==============================================================================
+/**
+ LadderUnroll: calls f(0), f(1) ... f(Count-1) through template recursion, so
+ a loop over the poles is written out in full for every pole count
+ */
+template <int Count>
+struct LadderUnroll
+{
+    template <class Function>
+    static inline void forEach(Function&& f)
+    {
+        LadderUnroll<Count-1>::forEach(f);
+        f(Count-1);
+    }
+};
+
+template <>
+struct LadderUnroll<0>
+{
+    template <class Function>
+    static inline void forEach(Function&&) {}
+};
+
+/** LadderPower: x to the power N by repeated squaring, unrolled at compile time */
+template <int N>
+struct LadderPower
+{
+    static inline double of(double x)
+    {
+        const double half = LadderPower<N/2>::of(x);
+        return N % 2 ? half*half*x : half*half;
+    }
+};
+
+template <>
+struct LadderPower<1>
+{
+    static inline double of(double x) { return x; }
+};
+
+template <>
+struct LadderPower<0>
+{
+    static inline double of(double) { return 1; }
+};
+
+/**
+ @returns the loop gain at which a ladder of the given pole count self
+          oscillates, 1/cos(pi/poles) to the power poles: 4 for four poles,
+          64/27 for six. Two poles never oscillate and take the four pole gain.
+          Written to be evaluated at compile time.
+ */
+constexpr double ladderFeedbackGain(int poles)
+{
+    if (poles == 2 || poles == 4)
+        return 4;
+
+    // cos(pi/poles) by its Taylor series, converged well before the last term
+    // for any poles >= 3
+    const double x = 3.14159265358979323846/poles;
+    double term = 1, cosine = 1;
+    for (int n = 1; n < 12; n++)
+    {
+        term *= -x*x/((2*n-1)*(2*n));
+        cosine += term;
+    }
+
+    double gain = 1;
+    for (int i = 0; i < poles; i++)
+        gain /= cosine;
+    return gain;
+}
+//==============================================================================
+/**
+ MoogLadder class: Initialised with sample rate (getSampleRate() in JUCE).
+ The state and coefficients are held as Sample; the NonlinearityPolicy is fixed
+ at compile time so the linear instances carry no tanh code.
+
+ Poles one pole stages are chained, each rolling off 6 dB/oct: 4 is the Moog
+ ladder, 2 a cheaper 12 dB/oct filter, 6 and 8 steeper ones. The feedback is
+ scaled so that full resonance is the edge of self oscillation for every
+ count, and the solve is unrolled for the count at compile time.
+ */
+template <typename Sample, typename NonlinearityPolicy, int Poles = 4>
+class MoogLadder
+{
+    static_assert(Poles >= 2, "a ladder needs at least two poles");
+
+public:
+    //==========================================================================
+    /** Constructor */
+    MoogLadder(){};
+    MoogLadder(double extSampRate)
+    {
+        init(extSampRate);
+    };
+    /** Destructor */
+    ~MoogLadder(){};
+    //==========================================================================
+    /**
+     apply Moog VCF filter to incoming audio samples
+
+     @param sample input audio sample
+     @param resonanceSideChain resonance: is in range [0,1]
+     @param cutoffSideChain cutoff: is in range [0,1]
+
+     @returns sample processed through MoogVCF algorithm
+     */
+    Sample filter (const Sample sample, const Sample resonanceSideChain, const Sample cutoffSideChain);
+
+    /**
+     apply Moog VCF filter to a block of audio samples with a static side chain.
+     The solve terms are set up once for the whole block.
+
+     @param in input audio samples
+     @param out processed audio samples (may be the same buffer as in)
+     @param numSamples number of samples in the block
+     @param resonanceSideChain resonance for the whole block
+     @param cutoffSideChain cutoff for the whole block
+     */
+    void processBlock (const float* in, float* out, int numSamples,
+                       const double resonanceSideChain, const double cutoffSideChain);
+
+    /**
+     apply Moog VCF filter to a block of audio samples with a side chain value per
+     sample. The solve terms are only set up again when a side chain changes, and
+     with a control interval above 1 only once per interval, see
+     setControlInterval().
+
+     @param in input audio samples
+     @param out processed audio samples (may be the same buffer as in)
+     @param numSamples number of samples in the block
+     @param resonanceSideChain resonance for each sample
+     @param cutoffSideChain cutoff for each sample
+     */
+    void processBlock (const float* in, float* out, int numSamples,
+                       const float* resonanceSideChain, const float* cutoffSideChain);
+    //==========================================================================
+    /** initialiase filter settings and coefficients
+     @param extSampRate sample rate of environment
+     */
+    void init(double extSampRate)
+    {
+        setSampleRate(extSampRate);
+    }
+
+    /**
+     zeroes the ladder state, so the next sample starts from silence rather
+     than from whatever the last one left ringing. Settings are kept.
+     */
+    void reset() { std::fill(x, x+Poles, (Sample) 0); }
+
+    /**
+     @returns the largest state magnitude. Unlike a single output sample this
+     does not dip at the zero crossings of a ringing ladder, since the stages
+     are out of phase, so it tells when a tail has died away.
+     */
+    Sample getStatePeak() const
+    {
+        Sample peak = 0;
+        for (int i = 0; i < Poles; i++)
+            peak = std::max(peak, (Sample) std::abs(x[i]));
+        return peak;
+    }
+
+    /**
+     chooses the tanh used by the nonlinear model, see LadderSaturation for the
+     error of each. Ignored by the linear model.
+
+     @param tier saturation tier
+     */
+    void setSaturation(LadderSaturation tier) { saturation = tier; }
+
+    /** @returns the tanh tier used by the nonlinear model */
+    LadderSaturation getSaturation() const { return saturation; }
+
+    /**
+     chooses how the nonlinear model solves each step, see LadderSolver for
+     the worst case cost of each. Ignored by the linear model, whose step is
+     solved exactly.
+
+     @param tier solver tier
+     */
+    void setSolver(LadderSolver tier) { solver = tier; }
+
+    /** @returns the solver tier used by the nonlinear model */
+    LadderSolver getSolver() const { return solver; }
+
+    /**
+     sets the side chains and the solve terms for them, also while frozen
+
+     @param resonanceSideChain resonance: is in range [0,1]
+     @param cutoffSideChain cutoff: is in range [0,1]
+     */
+    void setSideChains(double resonanceSideChain, double cutoffSideChain);
+
+    /**
+     freezes the side chains: filter() and processBlock() ignore their side chain
+     arguments and keep the cached solve terms until unfrozen. Use
+     setSideChains() to move a frozen filter.
+
+     @param shouldBeFrozen true to freeze, false to follow the side chains again
+     */
+    void setSideChainsFrozen(bool shouldBeFrozen);
+
+    /** @returns true if the side chains are frozen */
+    bool areSideChainsFrozen() const { return sideChainsFrozen; }
+
+    /**
+     sets how often processBlock() with per sample side chains reads them. At 1
+     every sample is read. Above 1 the block is split into spans of this many
+     samples: the side chains are read at the last sample of each span, the
+     solve terms set up for them once, and the terms in use moved linearly
+     towards them over the span. Slow sweeps sound the same for a fraction of
+     the set up cost; fast ones are smoothed and lag by up to one interval.
+
+     @param numSamples samples per control tick, e.g. 16, 32 or 64
+     */
+    void setControlInterval(int numSamples) { controlInterval = std::max(1, numSamples); }
+
+    /** @returns the samples per control tick */
+    int getControlInterval() const { return controlInterval; }
+
+    /**
+     sets whether the state is zeroed once it decays below
+     ladderFlushThreshold, after every filter() and processBlock(). Without
+     it a silent input leaves the state sinking into subnormals, which are
+     slow on some CPUs unless a ScopedFlushDenormals is in scope. On by
+     default; turn it off only to measure what it saves.
+
+     @param shouldFlush true to zero the decayed state
+     */
+    void setStateFlushing(bool shouldFlush) { stateFlushing = shouldFlush; }
+
+    /** @returns true if the decayed state is zeroed */
+    bool isStateFlushing() const { return stateFlushing; }
+    //==========================================================================
+    /** @returns the number of poles */
+    static int getNumPoles() { return Poles; }
+
+    /** @returns the loop gain at which the ladder self oscillates, see ladderFeedbackGain() */
+    static constexpr double getFeedbackGain() { return ladderFeedbackGain(Poles); }
+    //==========================================================================
+    /**
+     prints the current values of all matrices and vectors to standard character out
+     */
+    void printMatsAndVects();
+
+private:
+    //==========================================================================
+    /**
+     Terms of the update for the current side chains. With N poles and the
+     feedback gain G, I-kA/2 is lower bidiagonal with diagonal d = 1+wk/2 plus
+     the corner G/2*rho*wk, so it is solved by substitution; only the corner
+     and the D scaling depend on rho. For four poles G/2 is 2.
+     */
+    struct SolveTerms
+    {
+        /** normalised cutoff frequency w0*k */
+        Sample wk;
+        /** diagonal and off diagonal of I+kA/2: 1-wk/2 and wk/2 */
+        Sample ipkADiag, ipkAOffDiag;
+        /** k*(I+kA/2)*B over the input: wk-wk^2/2 and wk^2/2 */
+        Sample termA, termB;
+        /** corner of I-kA/2 over rho: G/2*wk */
+        Sample cornerWk;
+        /** 1/d^N, d^N and G/2*wk*(wk/2)^(N-1), the corner's share of the determinant over rho */
+        Sample recipDiagN, diagN, cornerWkN;
+        /** 1/d, d^(N-1) and G/2*wk*d^(N-2) */
+        Sample recipDiag, diagN1, cornerDiagN2;
+        /** (wk/2)/d: step of the substitution down the sub diagonal */
+        Sample subDiagRatio;
+        /** linear model only, where rho is r: the corner G/2*r*wk of I+kA/2
+            and the substitution terms D*d^(N-1), D*G/2*r*wk*d^(N-2) and D*det/d */
+        Sample ipkACorner, pivotDiag, pivotCorner, scaledRecipDiag;
+        /** the clamped resonance r */
+        Sample rs;
+
+        /** sets each term to (to - from)*scale: the step per sample between ticks */
+        void setStep(const SolveTerms& from, const SolveTerms& to, Sample scale)
+        {
+            wk = (to.wk - from.wk)*scale;
+            ipkADiag = (to.ipkADiag - from.ipkADiag)*scale;
+            ipkAOffDiag = (to.ipkAOffDiag - from.ipkAOffDiag)*scale;
+            termA = (to.termA - from.termA)*scale;
+            termB = (to.termB - from.termB)*scale;
+            cornerWk = (to.cornerWk - from.cornerWk)*scale;
+            recipDiagN = (to.recipDiagN - from.recipDiagN)*scale;
+            diagN = (to.diagN - from.diagN)*scale;
+            cornerWkN = (to.cornerWkN - from.cornerWkN)*scale;
+            recipDiag = (to.recipDiag - from.recipDiag)*scale;
+            diagN1 = (to.diagN1 - from.diagN1)*scale;
+            cornerDiagN2 = (to.cornerDiagN2 - from.cornerDiagN2)*scale;
+            subDiagRatio = (to.subDiagRatio - from.subDiagRatio)*scale;
+            ipkACorner = (to.ipkACorner - from.ipkACorner)*scale;
+            pivotDiag = (to.pivotDiag - from.pivotDiag)*scale;
+            pivotCorner = (to.pivotCorner - from.pivotCorner)*scale;
+            scaledRecipDiag = (to.scaledRecipDiag - from.scaledRecipDiag)*scale;
+            rs = (to.rs - from.rs)*scale;
+        }
+
+        /** adds step to each term */
+        void add(const SolveTerms& step)
+        {
+            wk += step.wk;
+            ipkADiag += step.ipkADiag;
+            ipkAOffDiag += step.ipkAOffDiag;
+            termA += step.termA;
+            termB += step.termB;
+            cornerWk += step.cornerWk;
+            recipDiagN += step.recipDiagN;
+            diagN += step.diagN;
+            cornerWkN += step.cornerWkN;
+            recipDiag += step.recipDiag;
+            diagN1 += step.diagN1;
+            cornerDiagN2 += step.cornerDiagN2;
+            subDiagRatio += step.subDiagRatio;
+            ipkACorner += step.ipkACorner;
+            pivotDiag += step.pivotDiag;
+            pivotCorner += step.pivotCorner;
+            scaledRecipDiag += step.scaledRecipDiag;
+            rs += step.rs;
+        }
+    };
+    //==========================================================================
+    /**
+     sets r and the solve terms again only for the side chains that changed,
+     unless frozen
+
+     @param resonanceSideChain resonance side chain value
+     @param cutoffSideChain cutoff side chain value
+     */
+    void updateSideChains(double resonanceSideChain, double cutoffSideChain);
+
+    /**
+     sets resonance and the clamped r from the resonance side chain
+
+     @param resonanceSideChain resonance side chain value
+     */
+    void setResonance(double resonanceSideChain);
+
+    /**
+     sets cutoff and w0 from the cutoff side chain and fills the cutoff terms
+
+     @param cutoffSideChain cutoff side chain value
+     */
+    void setCutoffTerms(double cutoffSideChain);
+
+    /**
+     fills the terms that the linear model fixes with rho = r
+     */
+    void setLinearTerms();
+
+    /**
+     zeroes each state below ladderFlushThreshold, if state flushing is on
+     */
+    void flushState()
+    {
+        if (! stateFlushing)
+            return;
+
+        for (int i = 0; i < Poles; i++)
+            if (std::abs(x[i]) < (Sample) ladderFlushThreshold)
+                x[i] = 0;
+    }
+
+    /**
+     @returns the tier to dispatch on: constant for the linear model, so the
+     nonlinear branches fold away
+     */
+    LadderSaturation activeSaturation() const
+    {
+        return NonlinearityPolicy::isLinear ? LadderSaturation::exact : saturation;
+    }
+
+    /** @returns the solver tier to dispatch on, constant for the linear model */
+    LadderSolver activeSolver() const
+    {
+        return NonlinearityPolicy::isLinear ? LadderSolver::linearised : solver;
+    }
+
+    /**
+     calls process(kernel, solve) with a tanh kernel and a solve for the
+     active tiers, so the loop it runs is compiled for them
+     */
+    template <class Process>
+    void withKernels(Process&& process) const
+    {
+        switch (activeSaturation())
+        {
+            case LadderSaturation::rational: withSolve<RationalTanh>(process); break;
+            case LadderSaturation::table:    withSolve<TableTanh>(process);    break;
+            default:                         withSolve<ExactTanh>(process);    break;
+        }
+    }
+
+    template <class Tanh, class Process>
+    void withSolve(Process&& process) const
+    {
+        switch (activeSolver())
+        {
+            case LadderSolver::implicitDraft:    process(Tanh(), ImplicitDraftSolve());    break;
+            case LadderSolver::implicitStandard: process(Tanh(), ImplicitStandardSolve()); break;
+            case LadderSolver::implicitPrecise:  process(Tanh(), ImplicitPreciseSolve());  break;
+            default:                             process(Tanh(), LinearisedSolve());       break;
+        }
+    }
+
+    /**
+     @returns D, which scales the adjugate of I-kA/2 in place of 1/det. The
+     four pole ladder keeps the 1/d^4 plus corner term it has always used,
+     which is slightly above 1/det and so adds a little gain to every step;
+     the other pole counts, where that gain would make them unstable near
+     full resonance, use 1/det.
+
+     @param recipDiagN 1/d^N
+     @param cornerTerm the corner's share of the determinant
+     @param det determinant of I-kA/2
+     */
+    template <typename Value>
+    static Value solveScale(Value recipDiagN, Value cornerTerm, Value det)
+    {
+        return Poles == 4 ? recipDiagN + cornerTerm : (Value) 1/det;
+    }
+
+    /**
+     advances the ladder state by one sample with the given solve terms, by
+     the linearisation or the implicit solve as Solve says
+
+     @param state ladder state, updated in place
+     @param in input audio sample
+     @param t solve terms to use
+     @returns the new ladder output tap
+     */
+    template <class Tanh, class Solve>
+    static Sample advance(Sample (&state)[Poles], Sample in, const SolveTerms& t)
+    {
+        return Solve::maxIterations > 0 ? tickImplicit<Tanh, Solve>(state, in, t)
+                                        : tick<Tanh>(state, in, t);
+    }
+
+    /**
+     advances the ladder state by one sample with the given solve terms, by
+     the linearisation
+
+     @param state ladder state, updated in place
+     @param in input audio sample
+     @param t solve terms to use
+     @returns the new ladder output tap
+     */
+    template <class Tanh>
+    static Sample tick(Sample (&state)[Poles], Sample in, const SolveTerms& t);
+
+    /**
+     advances the nonlinear ladder state by one sample with the given solve
+     terms, by Newton's method on the trapezoidal step
+
+     @param state ladder state, updated in place
+     @param in input audio sample
+     @param t solve terms to use, only wk and rs are read
+     @returns the new ladder output tap
+     */
+    template <class Tanh, class Solve>
+    static Sample tickImplicit(Sample (&state)[Poles], Sample in, const SolveTerms& t);
+
+    /**
+     runs advance over a block with static solve terms
+     */
+    template <class Tanh, class Solve>
+    void tickBlock(Sample (&state)[Poles], const float* in, float* out, int numSamples);
+
+    /**
+     runs advance over a block with per sample side chains
+     */
+    template <class Tanh, class Solve>
+    void tickBlock(Sample (&state)[Poles], const float* in, float* out, int numSamples,
+                   const float* resonanceSideChain, const float* cutoffSideChain);
+
+    /**
+     runs advance over a block, reading the side chains once per control interval
+     and interpolating the solve terms between reads
+     */
+    template <class Tanh, class Solve>
+    void tickBlockInterpolated(Sample (&state)[Poles], const float* in, float* out, int numSamples,
+                               const float* resonanceSideChain, const float* cutoffSideChain);
+
+    /**
+     Sets the internal sample rate and time step values
+
+     @param extSampRate sample rate from external environment (e.g. JUCE)
+     */
+    void setSampleRate(double extSampRate);
+    //==========================================================================
+    /**
+     Trim variable to equal max or min if out
+     of range
+
+     @param var variable to be trimmed
+     @param max maximum value
+     @param min minimum value
+     */
+    void trimRange(double &var, double max, double min);
+    //==========================================================================
+public:
+
+    /** resonance side chain last applied: is in range [0,1] */
+    double resonance = 0.5;
+    /** cutoff side chain last applied: is in range [0,1] */
+    double cutoff = .7;
+    //==========================================================================
+private:
+    /** internal pi constant */
+    const double pi = 3.1415926536;
+    /** resonance parameter */
+    double r = 0.9; // resonance variable
+    /** cutoff frequency: w0 is in the range 2*pi*[20,20k] */
+    double w0 = 2*pi*20*pow(2,10*(0.9f));
+    /** internal sampleRate */
+    double sampleRate = 44100;
+    /** internal time step (1/sampleRate) */
+    double timeStep = 1/44100.;
+
+    /** ladder state, the last stage is the output tap */
+    Sample x[Poles] = {};
+    /** tanh used by the nonlinear update */
+    LadderSaturation saturation = LadderSaturation::JOEY_MOOG_SATURATION;
+    /** how the nonlinear update solves each step */
+    LadderSolver solver = LadderSolver::JOEY_MOOG_SOLVER;
+    /** solve terms for the current side chains */
+    SolveTerms terms;
+    /** true once terms matches resonance and cutoff */
+    bool termsValid = false;
+    /** true while the side chain arguments are ignored */
+    bool sideChainsFrozen = false;
+    /** samples between side chain reads in processBlock(), 1 for every sample */
+    int controlInterval = 1;
+    /** true to zero the state once it has decayed below ladderFlushThreshold */
+    bool stateFlushing = true;
+    //==========================================================================
+};
+
+//==============================================================================
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::setSampleRate(double extSampRate)
+{
+    sampleRate = extSampRate;
+    timeStep = 1/sampleRate;
+    termsValid = false;
+}
+//==============================================================================
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+Sample MoogLadder<Sample, NonlinearityPolicy, Poles>::filter(const Sample sample, const Sample resonanceSideChain, const Sample cutoffSideChain)
+{
+    //==========================================================================
+    updateSideChains(resonanceSideChain, cutoffSideChain);
+    //==========================================================================
+    Sample output;
+    withKernels([&] (auto kernel, auto solve)
+    {
+        output = advance<decltype(kernel), decltype(solve)>(x, sample, terms);
+    });
+
+    flushState();
+    return output;
+}
+//==============================================================================
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::processBlock(const float* in, float* out, const int numSamples,
+                                                                 const double resonanceSideChain, const double cutoffSideChain)
+{
+    // side chain is static: only the nonlinear terms change per sample
+    updateSideChains(resonanceSideChain, cutoffSideChain);
+
+    Sample state[Poles];
+    LadderUnroll<Poles>::forEach([&] (int i) { state[i] = x[i]; });
+
+    withKernels([&] (auto kernel, auto solve)
+    {
+        tickBlock<decltype(kernel), decltype(solve)>(state, in, out, numSamples);
+    });
+
+    LadderUnroll<Poles>::forEach([&] (int i) { x[i] = state[i]; });
+    flushState();
+}
+
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::processBlock(const float* in, float* out, const int numSamples,
+                                                                 const float* resonanceSideChain, const float* cutoffSideChain)
+{
+    Sample state[Poles];
+    LadderUnroll<Poles>::forEach([&] (int i) { state[i] = x[i]; });
+
+    withKernels([&] (auto kernel, auto solve)
+    {
+        if (controlInterval > 1)
+            tickBlockInterpolated<decltype(kernel), decltype(solve)>(state, in, out, numSamples,
+                                                                     resonanceSideChain, cutoffSideChain);
+        else
+            tickBlock<decltype(kernel), decltype(solve)>(state, in, out, numSamples,
+                                                         resonanceSideChain, cutoffSideChain);
+    });
+
+    LadderUnroll<Poles>::forEach([&] (int i) { x[i] = state[i]; });
+    flushState();
+}
+//==============================================================================
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+template <class Tanh, class Solve>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::tickBlock(Sample (&state)[Poles],
+                                                              const float* in, float* out, const int numSamples)
+{
+    for (int n = 0; n < numSamples; n++)
+        out[n] = (float) advance<Tanh, Solve>(state, (Sample) in[n], terms);
+}
+
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+template <class Tanh, class Solve>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::tickBlock(Sample (&state)[Poles],
+                                                              const float* in, float* out, const int numSamples,
+                                                              const float* resonanceSideChain, const float* cutoffSideChain)
+{
+    for (int n = 0; n < numSamples; n++)
+    {
+        updateSideChains(resonanceSideChain[n], cutoffSideChain[n]);
+        out[n] = (float) advance<Tanh, Solve>(state, (Sample) in[n], terms);
+    }
+}
+
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+template <class Tanh, class Solve>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::tickBlockInterpolated(Sample (&state)[Poles],
+                                                                          const float* in, float* out, const int numSamples,
+                                                                          const float* resonanceSideChain, const float* cutoffSideChain)
+{
+    // a filter that has never been set up starts from its first side chains,
+    // which an empty block does not have
+    if (! termsValid && numSamples > 0)
+        updateSideChains(resonanceSideChain[0], cutoffSideChain[0]);
+
+    for (int start = 0; start < numSamples; start += controlInterval)
+    {
+        const int spanSize = std::min(controlInterval, numSamples - start);
+        const int last = start + spanSize - 1;
+
+        if (sideChainsFrozen
+            || (resonanceSideChain[last] == resonance && cutoffSideChain[last] == cutoff))
+        {
+            tickBlock<Tanh, Solve>(state, in + start, out + start, spanSize);
+            continue;
+        }
+
+        // set up the terms for the end of the span, then walk there from the
+        // terms in use, landing on them exactly at its last sample
+        SolveTerms current = terms;
+        updateSideChains(resonanceSideChain[last], cutoffSideChain[last]);
+
+        SolveTerms step;
+        step.setStep(current, terms, (Sample) 1/spanSize);
+
+        for (int n = start; n < last; n++)
+        {
+            current.add(step);
+            out[n] = (float) advance<Tanh, Solve>(state, (Sample) in[n], current);
+        }
+
+        out[last] = (float) advance<Tanh, Solve>(state, (Sample) in[last], terms);
+    }
+}
+//==============================================================================
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::setSideChains(const double resonanceSideChain, const double cutoffSideChain)
+{
+    setResonance(resonanceSideChain);
+    setCutoffTerms(cutoffSideChain);
+    setLinearTerms();
+    termsValid = true;
+}
+
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::setSideChainsFrozen(const bool shouldBeFrozen)
+{
+    sideChainsFrozen = shouldBeFrozen;
+}
+//==============================================================================
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::updateSideChains(const double resonanceSideChain, const double cutoffSideChain)
+{
+    if (sideChainsFrozen && termsValid)
+        return;
+
+    const bool resonanceChanged = ! termsValid || resonanceSideChain != resonance;
+    const bool cutoffChanged = ! termsValid || cutoffSideChain != cutoff;
+
+    if (resonanceChanged)
+        setResonance(resonanceSideChain);
+
+    if (cutoffChanged)
+        setCutoffTerms(cutoffSideChain);
+
+    if (resonanceChanged || cutoffChanged)
+        setLinearTerms();
+
+    termsValid = true;
+}
+
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::setResonance(const double resonanceSideChain)
+{
+    resonance = resonanceSideChain;
+    r = resonance;
+    trimRange(r, 0., .9873);
+    terms.rs = (Sample) r;
+}
+
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::setCutoffTerms(const double cutoffSideChain)
+{
+    cutoff = cutoffSideChain;
+    w0 = CutoffToW0::process(cutoff);
+    trimRange(w0, 0., .5*sampleRate);
+
+    const double wk = w0*timeStep;
+    const double d = 1.0+0.5*wk;    // diagonal of I-kA/2
+    constexpr double halfGain = 0.5*getFeedbackGain();
+    const double cornerWk = halfGain*wk;
+    const double diagN = LadderPower<Poles>::of(d);
+
+    terms.wk = (Sample) wk;
+    terms.ipkADiag = (Sample) (1.0-0.5*wk);
+    terms.ipkAOffDiag = (Sample) (0.5*wk);
+    terms.termA = (Sample) (wk-0.5*wk*wk);
+    terms.termB = (Sample) (0.5*wk*wk);
+    terms.cornerWk = (Sample) cornerWk;
+
+    terms.diagN = (Sample) diagN;
+    terms.recipDiagN = (Sample) (1.0/diagN);
+    terms.cornerWkN = (Sample) (cornerWk*LadderPower<Poles-1>::of(0.5*wk));
+    terms.recipDiag = (Sample) (1.0/d);
+    terms.diagN1 = (Sample) LadderPower<Poles-1>::of(d);
+    terms.cornerDiagN2 = (Sample) (cornerWk*LadderPower<Poles-2>::of(d));
+    terms.subDiagRatio = (Sample) (0.5*wk/d);
+}
+
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::setLinearTerms()
+{
+    if (! NonlinearityPolicy::isLinear)
+        return;
+
+    const double wk = w0*timeStep;
+    const double d = 1.0+0.5*wk;
+    constexpr double halfGain = 0.5*getFeedbackGain();
+    const double corner = halfGain*r*wk;
+
+    // determinant = pow(d,N) + corner*pow(wk/2,N-1)
+    const double diagN = LadderPower<Poles>::of(d);
+    const double cornerWkN = corner*LadderPower<Poles-1>::of(0.5*wk);
+    const double det = diagN + cornerWkN;
+    const double D = solveScale(1.0/diagN, cornerWkN, det); // scales the adjugate of Im in place of 1/det
+
+    terms.ipkACorner = (Sample) corner;
+    terms.pivotDiag = (Sample) (D*LadderPower<Poles-1>::of(d));
+    terms.pivotCorner = (Sample) (D*corner*LadderPower<Poles-2>::of(d));
+    terms.scaledRecipDiag = (Sample) (D*det/d);
+}
+//==============================================================================
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+template <class Tanh>
+inline Sample MoogLadder<Sample, NonlinearityPolicy, Poles>::tick(Sample (&state)[Poles], const Sample in, const SolveTerms& t)
+{
+    const Sample one = 1;
+    const int last = Poles-1;
+    Sample sat[Poles], v[Poles], inTermA, inTermB, corner, pivotDiag, pivotCorner, scaledRecipDiag;
+
+    if (NonlinearityPolicy::isLinear)
+    {
+        std::copy(state, state+Poles, sat);
+        inTermA = in*t.termA;
+        inTermB = in*t.termB;
+        corner = t.ipkACorner;
+        pivotDiag = t.pivotDiag;
+        pivotCorner = t.pivotCorner;
+        scaledRecipDiag = t.scaledRecipDiag;
+    }
+    else
+    {
+        // every tanh argument is evaluated once per sample
+        LadderUnroll<Poles>::forEach([&] (int i) { sat[i] = Tanh::process(state[i]); });
+
+        constexpr Sample gain = (Sample) getFeedbackGain();
+        const Sample rs = t.rs;
+        const Sample tanhIn = Tanh::process(in);
+        Sample mu = one;
+        if (in!=0)
+            mu = tanhIn/in;
+        Sample rho = rs;
+        if (state[last]!=0)
+            rho = Tanh::process(gain*rs*state[last])/(gain*sat[last]);
+
+        const Sample tanhrxN = Tanh::process(rs*state[last]);
+        const Sample B = mu*(one-tanhrxN*tanhrxN)/(one-tanhIn*tanhrxN);
+        inTermA = in*(B*t.termA);
+        inTermB = in*(B*t.termB);
+        corner = rho*t.cornerWk;
+
+        // D scales the adjugate of I-kA/2 in place of 1/determinant, so the
+        // solve is scaled by D*det
+        const Sample det = t.diagN + t.cornerWkN*rho;
+        const Sample D = solveScale(t.recipDiagN, t.cornerWkN*rho, det);
+        pivotDiag = D*t.diagN1;
+        pivotCorner = D*rho*t.cornerDiagN2;
+        scaledRecipDiag = D*det*t.recipDiag;
+    }
+
+    // v = (I+kA/2)x + k*(I+kA/2)*B*input, with x saturated in the nonlinear model
+    const Sample a = t.ipkADiag;
+    const Sample b = t.ipkAOffDiag;
+    v[0] = sat[0]*a - sat[last]*corner + inTermA;
+    LadderUnroll<last>::forEach([&] (int i) { v[i+1] = sat[i]*b + sat[i+1]*a; });
+    v[1] += inTermB;
+
+    // x = inv(I-kA/2)*v by substitution: the rows below the first put
+    // x[last] in terms of x[0], the first row then gives x[0]
+    const Sample g = t.subDiagRatio;
+    Sample tail = v[1];
+    LadderUnroll<last-1>::forEach([&] (int i) { tail = tail*g + v[i+2]; });
+
+    state[0] = pivotDiag*v[0] - pivotCorner*tail;
+    LadderUnroll<last>::forEach([&] (int i) { state[i+1] = g*state[i] + scaledRecipDiag*v[i+1]; });
+
+    return state[last];
+}
+
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+template <class Tanh, class Solve>
+inline Sample MoogLadder<Sample, NonlinearityPolicy, Poles>::tickImplicit(Sample (&state)[Poles], const Sample in, const SolveTerms& t)
+{
+    const Sample one = 1;
+    const int last = Poles-1;
+    constexpr Sample gain = (Sample) getFeedbackGain();
+    const Sample feedback = gain*t.rs;
+    const Sample h = t.ipkAOffDiag;     // wk/2
+    const Sample tolerance = std::max((Sample) Solve::tolerance(), 16*std::numeric_limits<Sample>::epsilon());
+
+    // the ladder equations over w0 are f_0 = tanh(in - G*r*x_last) - tanh(x_0)
+    // and f_i = tanh(x_(i-1)) - tanh(x_i); the trapezoidal step is the x with
+    // x = state + h*(f(state) + f(x))
+    Sample sat[Poles], drive;
+    auto saturate = [&] (const Sample (&at)[Poles])
+    {
+        LadderUnroll<Poles>::forEach([&] (int i) { sat[i] = Tanh::process(at[i]); });
+        drive = Tanh::process(in - feedback*at[last]);
+    };
+    auto derivative = [&] (int i) { return (i == 0 ? drive : sat[i-1]) - sat[i]; };
+
+    // warm start from the previous state: the first iteration's residual is
+    // -2h*f(state), so it needs no tanh beyond the ones for f(state)
+    Sample next[Poles], known[Poles], residual[Poles];
+    saturate(state);
+    LadderUnroll<Poles>::forEach([&] (int i)
+    {
+        next[i] = state[i];
+        known[i] = state[i] + h*derivative(i);
+    });
+
+    for (int iteration = 0; iteration < Solve::maxIterations; iteration++)
+    {
+        if (iteration > 0)
+            saturate(next);
+
+        LadderUnroll<Poles>::forEach([&] (int i) { residual[i] = next[i] - known[i] - h*derivative(i); });
+
+        // Newton step: the Jacobian of the residual has the same shape as
+        // I-kA/2, diagonal 1+h*s_i, sub diagonal -h*s_(i-1) and corner
+        // h*G*r*u, with s = 1-tanh^2 of each state and u that of the drive.
+        // Substitute down the rows with delta_i = a_i + b_i*delta_0, then the
+        // first row gives delta_0
+        Sample slope[Poles], a[Poles], b[Poles];
+        LadderUnroll<Poles>::forEach([&] (int i) { slope[i] = h*(one - sat[i]*sat[i]); });
+        a[0] = 0;
+        b[0] = one;
+        LadderUnroll<last>::forEach([&] (int i)
+        {
+            const Sample recipDiag = one/(one + slope[i+1]);
+            a[i+1] = (slope[i]*a[i] - residual[i+1])*recipDiag;
+            b[i+1] = slope[i]*b[i]*recipDiag;
+        });
+
+        const Sample corner = h*feedback*(one - drive*drive);
+        const Sample delta0 = (-residual[0] - corner*a[last])/(one + slope[0] + corner*b[last]);
+
+        Sample largest = 0;
+        LadderUnroll<Poles>::forEach([&] (int i)
+        {
+            const Sample delta = a[i] + b[i]*delta0;
+            next[i] += delta;
+            largest = std::max(largest, std::abs(delta));
+        });
+
+        if (largest < tolerance)
+            break;
+    }
+
+    LadderUnroll<Poles>::forEach([&] (int i) { state[i] = next[i]; });
+    return state[last];
+}
+//==============================================================================
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::trimRange(double &var, const double min, const double max)
+{
+    if (var < min){var = min;}
+    if (var > max){var = max;}
+}
+//==============================================================================
+template <typename Sample, typename NonlinearityPolicy, int Poles>
+void MoogLadder<Sample, NonlinearityPolicy, Poles>::printMatsAndVects()
+{
+    // Im and INV are not kept by the filter, rebuild them for the current side
+    // chains with rho = r. INV is what the substitution applies, column by
+    // column: D*det times the inverse of Im
+    const double wk = w0*timeStep;
+    const double d = 1.0+0.5*wk;
+    const double o = -0.5*wk;
+    const double c = 0.5*getFeedbackGain()*r*wk;
+    const double diagN = LadderPower<Poles>::of(d);
+    const double cornerWkN = c*LadderPower<Poles-1>::of(-o);
+    const double D = solveScale(1.0/diagN, cornerWkN, diagN + cornerWkN);
+    const double g = -o/d;
+
+    double Im[Poles][Poles] = {}, INV[Poles][Poles];
+
+    for (int i = 0; i < Poles; i++)
+    {
+        Im[i][i] = d;
+        if (i > 0)
+            Im[i][i-1] = o;
+    }
+    Im[0][Poles-1] = c;
+
+    for (int j = 0; j < Poles; j++)
+    {
+        double tail = 0;
+        for (int i = 1; i < Poles; i++)
+            tail = tail*g + (i == j ? 1 : 0);
+
+        INV[0][j] = (j == 0 ? D*LadderPower<Poles-1>::of(d) : 0) - D*c*LadderPower<Poles-2>::of(d)*tail;
+        for (int i = 1; i < Poles; i++)
+            INV[i][j] = g*INV[i-1][j] + (i == j ? D*(diagN + cornerWkN)/d : 0);
+    }
+
+    printf("x:\n");
+    for (int i = 0; i < Poles; i++) {
+        printf("%.3f\n", (double) x[i]);
+    }
+    printf("\n");
+
+    printf("Im:\n");
+    for (int i = 0; i < Poles; i++)
+    {
+        for (int j = 0; j < Poles; j++)
+        {
+            printf("%.4f\t",Im[i][j]);
+        }
+        printf("\n");
+    }
+    printf("\n");
+
+    printf("INV:\n");
+    for (int i = 0; i < Poles; i++)
+    {
+        for (int j = 0; j < Poles; j++)
+        {
+            printf("%.4f\t",INV[i][j]);
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
+//==============================================================================
+/**
+ Ladder: a MoogLadder named by its pole count first, e.g. Ladder<2> for a
+ 12 dB/oct voice or Ladder<8, float, NonLinearLadder> for a 48 dB/oct one.
+ Ladder<4> is JoeyMoogSC.
+ */
+template <int Poles, typename Sample = double, typename NonlinearityPolicy = LinearLadder>
+using Ladder = MoogLadder<Sample, NonlinearityPolicy, Poles>;
+
+#endif /* MoogLadder_hpp */
@@ -0,0 +1,140 @@
+#include "MoogLadderBank.hpp"
+
+//==============================================================================
+void MoogLadderBank::init(double extSampRate, int extNumFilters)
+{
+    sampleRate = extSampRate;
+    timeStep = 1/sampleRate;
+    numFilters = extNumFilters;
+    numLanes = ((numFilters + LadderVec::width - 1)/LadderVec::width)*LadderVec::width;
+
+    for (int i = 0; i < 4; i++)
+        x[i].assign(numLanes, 0.0f);
+
+    for (std::vector<float>* v : { &r, &wk, &recipDiag4, &diag4, &quarterWk4, &recipDiag, &d3, &cd2, &subDiagRatio })
+        v->assign(numLanes, 0.0f);
+
+    for (int i = 0; i < numLanes; i++)
+        setSideChains(i, 0.0, .7);
+}
+//==============================================================================
+void MoogLadderBank::setSideChains(int filter, double resonanceSideChain, double cutoffSideChain)
+{
+    double rf = resonanceSideChain;
+    if (rf < 0.){rf = 0.;}
+    if (rf > .9873){rf = .9873;}
+
+    double w0 = CutoffToW0::process(cutoffSideChain);
+    if (w0 < 0.){w0 = 0.;}
+    if (w0 > .5*sampleRate){w0 = .5*sampleRate;}
+
+    const double normFreq = w0*timeStep;
+    const double d = 1.0+0.5*normFreq;    // diagonal of I-kA/2
+    const double c = 2*normFreq;          // corner of I-kA/2 over rho
+
+    r[filter]            = (float) rf;
+    wk[filter]           = (float) normFreq;
+    recipDiag4[filter]   = (float) (1.0/((d*d)*(d*d)));
+    diag4[filter]        = (float) ((d*d)*(d*d));
+    quarterWk4[filter]   = (float) (0.25*(normFreq*normFreq)*(normFreq*normFreq));
+    recipDiag[filter]    = (float) (1.0/d);
+    d3[filter]           = (float) (d*d*d);
+    cd2[filter]          = (float) (c*d*d);
+    subDiagRatio[filter] = (float) (0.5*normFreq/d);
+}
+//==============================================================================
+void MoogLadderBank::processBlock(const float* const* in, float* const* out, const int numSamples)
+{
+    const int W = LadderVec::width;
+    const LadderVec one  = LadderVec::fill(1.0f);
+    const LadderVec half = LadderVec::fill(0.5f);
+    const LadderVec two  = LadderVec::fill(2.0f);
+    const LadderVec four = LadderVec::fill(4.0f);
+
+    for (int base = 0; base < numLanes; base += W)
+    {
+        //======================================================================
+        // coefficients and state live in registers for the whole block
+        const LadderVec rv     = LadderVec::load(&r[base]);
+        const LadderVec wkv    = LadderVec::load(&wk[base]);
+        const LadderVec recD4  = LadderVec::load(&recipDiag4[base]);
+        const LadderVec D4     = LadderVec::load(&diag4[base]);
+        const LadderVec qWk4   = LadderVec::load(&quarterWk4[base]);
+        const LadderVec recD   = LadderVec::load(&recipDiag[base]);
+        const LadderVec D3     = LadderVec::load(&d3[base]);
+        const LadderVec CD2    = LadderVec::load(&cd2[base]);
+        const LadderVec g      = LadderVec::load(&subDiagRatio[base]);
+
+        const LadderVec a      = one - half*wkv;
+        const LadderVec b      = half*wkv;
+        const LadderVec termA  = wkv - half*wkv*wkv;
+        const LadderVec termB  = half*wkv*wkv;
+        const LadderVec fourR  = four*rv;
+
+        LadderVec x0 = LadderVec::load(&x[0][base]);
+        LadderVec x1 = LadderVec::load(&x[1][base]);
+        LadderVec x2 = LadderVec::load(&x[2][base]);
+        LadderVec x3 = LadderVec::load(&x[3][base]);
+
+        const int lanesUsed = numFilters - base < W ? numFilters - base : W;
+        float lane[LadderVec::width];
+
+        for (int n = 0; n < numSamples; n++)
+        {
+            for (int l = 0; l < W; l++)
+                lane[l] = l < lanesUsed ? in[base+l][n] : 0.0f;
+            const LadderVec s = LadderVec::load(lane);
+
+            //==================================================================
+            const LadderVec tanhIn = RationalTanh::process(s);
+            const LadderVec t0 = RationalTanh::process(x0);
+            const LadderVec t1 = RationalTanh::process(x1);
+            const LadderVec t2 = RationalTanh::process(x2);
+            const LadderVec t3 = RationalTanh::process(x3);
+
+            const LadderVec mu  = selectNonZero(s, tanhIn/s, one);
+            const LadderVec rho = selectNonZero(x3, RationalTanh::process(fourR*x3)/(four*t3), rv);
+
+            const LadderVec tanhrx3 = RationalTanh::process(rv*x3);
+            const LadderVec B = mu*(one - tanhrx3*tanhrx3)/(one - tanhIn*tanhrx3);
+
+            //==================================================================
+            // (I+kA/2)tanh(x) + k*(I+kA/2)*B*input
+            const LadderVec v0 = t0*a - t3*two*rho*wkv + s*B*termA;
+            const LadderVec v1 = t0*b + t1*a + s*B*termB;
+            const LadderVec v2 = t1*b + t2*a;
+            const LadderVec v3 = t2*b + t3*a;
+
+            // inv(I-kA/2)*v by substitution, scaled by D*det as in JoeyNonLinearMoogSC
+            const LadderVec D = recD4 + qWk4*rho;
+            const LadderVec scaledRecD = D*(D4 + qWk4*rho)*recD;
+
+            x0 = D*(D3*v0 - rho*CD2*((v1*g + v2)*g + v3));
+            x1 = g*x0 + scaledRecD*v1;
+            x2 = g*x1 + scaledRecD*v2;
+            x3 = g*x2 + scaledRecD*v3;
+
+            //==================================================================
+            x3.store(lane);
+            for (int l = 0; l < lanesUsed; l++)
+                out[base+l][n] = lane[l];
+        }
+
+        x0.store(&x[0][base]);
+        x1.store(&x[1][base]);
+        x2.store(&x[2][base]);
+        x3.store(&x[3][base]);
+    }
+
+    // zero the state once it has decayed, so silence cannot leave it in subnormals
+    for (int i = 0; i < 4; i++)
+        for (int filter = 0; filter < numFilters; filter++)
+            if (std::abs(x[i][filter]) < (float) ladderFlushThreshold)
+                x[i][filter] = 0.0f;
+}
+//==============================================================================
+void MoogLadderBank::reset()
+{
+    for (int i = 0; i < 4; i++)
+        std::fill(x[i].begin(), x[i].end(), 0.0f);
+}
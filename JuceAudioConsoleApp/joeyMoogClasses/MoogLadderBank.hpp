@@ -0,0 +1,103 @@
+//
+//  MoogLadderBank.hpp
+//
+//  A bank of independent nonlinear Moog ladder filters stepped several at a
+//  time with SIMD. Same model as JoeyNonLinearMoogSC, run in float with the
+//  rational tanh.
+//
+
+#ifndef MoogLadderBank_hpp
+#define MoogLadderBank_hpp
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "LadderSaturation.hpp"
+#include "LadderCutoff.hpp"
+#include "LadderDenormals.hpp"
+/**
+ MoogLadderBank class: holds numFilters nonlinear ladders in structure of
+ arrays layout so that LadderVec::width of them (4 with NEON/SSE, 8 with AVX)
+ are updated by each vector instruction. Each filter has its own state, cutoff
+ and resonance and reads and writes its own buffer.
+ */
+class MoogLadderBank
+{
+public:
+    //==========================================================================
+    /** Constructor */
+    MoogLadderBank(){};
+    MoogLadderBank(double extSampRate, int numFilters)
+    {
+        init(extSampRate, numFilters);
+    };
+    /** Destructor */
+    ~MoogLadderBank(){};
+    //==========================================================================
+    /**
+     initialise the bank, allocating state for the filters. Not real time safe.
+
+     @param extSampRate sample rate of environment
+     @param numFilters number of independent filters in the bank
+     */
+    void init(double extSampRate, int numFilters);
+
+    /**
+     sets the side chains of one filter in the bank
+
+     @param filter index of the filter
+     @param resonanceSideChain resonance: is in range [0,1]
+     @param cutoffSideChain cutoff: is in range [0,1]
+     */
+    void setSideChains(int filter, double resonanceSideChain, double cutoffSideChain);
+
+    /**
+     apply every filter in the bank to its own block of audio samples
+
+     @param in one input buffer per filter
+     @param out one output buffer per filter (may be the same buffers as in)
+     @param numSamples number of samples in each buffer
+     */
+    void processBlock(const float* const* in, float* const* out, int numSamples);
+
+    /** clears the ladder state of every filter */
+    void reset();
+
+    /** @returns the number of filters in the bank */
+    int getNumFilters() const { return numFilters; }
+
+    /** @returns the number of filters stepped together by one vector instruction */
+    static int getLaneWidth() { return LadderVec::width; }
+
+private:
+    //==========================================================================
+    /** internal pi constant */
+    const double pi = 3.1415926536;
+    /** internal sampleRate */
+    double sampleRate = 44100;
+    /** internal time step (1/sampleRate) */
+    double timeStep = 1/44100.;
+    /** number of filters in use */
+    int numFilters = 0;
+    /** number of filters rounded up to a whole number of vectors */
+    int numLanes = 0;
+    //==========================================================================
+    // one entry per filter (lane) in each array
+
+    /** VCF ladder state */
+    std::vector<float> x[4];
+    /** clamped resonance */
+    std::vector<float> r;
+    /** normalised cutoff frequency w0*k */
+    std::vector<float> wk;
+    /** 1/d^4, d^4 and wk^4/4 for the diagonal d = 1+wk/2 of I-kA/2: the solve
+        is scaled by D*det with D = recipDiag4 + quarterWk4*rho and
+        det = diag4 + quarterWk4*rho */
+    std::vector<float> recipDiag4, diag4, quarterWk4;
+    /** 1/d, d^3 and 2*wk*d^2 (the corner 2*rho*wk without the rho) */
+    std::vector<float> recipDiag, d3, cd2;
+    /** (wk/2)/d: step of the substitution down the sub diagonal */
+    std::vector<float> subDiagRatio;
+};
+
+#endif /* MoogLadderBank_hpp */
@@ -0,0 +1,49 @@
+#include "OversampledMoogLadder.hpp"
+
+//==============================================================================
+void OversampledMoogLadder::init(const double extSampRate, const int maxBlockSize, const int maxFactor)
+{
+    sampleRate = extSampRate;
+    oversampler.init(maxFactor, maxBlockSize);
+    resonanceHeld.assign(maxBlockSize*oversampler.getFactor(), 0.0f);
+    cutoffHeld.assign(maxBlockSize*oversampler.getFactor(), 0.0f);
+    setOversamplingFactor(1);
+}
+
+void OversampledMoogLadder::setOversamplingFactor(const int factor)
+{
+    oversampler.setFactor(factor);
+    ladder.init(sampleRate*oversampler.getFactor());
+}
+//==============================================================================
+void OversampledMoogLadder::processBlock(const float* in, float* out, const int numSamples,
+                                         const double resonanceSideChain, const double cutoffSideChain)
+{
+    const int factor = oversampler.getFactor();
+    float* fast = oversampler.upsample(in, numSamples);
+    ladder.processBlock(fast, fast, numSamples*factor, resonanceSideChain, cutoffSideChain);
+    oversampler.downsample(out, numSamples);
+}
+
+void OversampledMoogLadder::processBlock(const float* in, float* out, const int numSamples,
+                                         const float* resonanceSideChain, const float* cutoffSideChain)
+{
+    const int factor = oversampler.getFactor();
+    float* fast = oversampler.upsample(in, numSamples);
+
+    if (factor == 1)
+    {
+        ladder.processBlock(fast, fast, numSamples, resonanceSideChain, cutoffSideChain);
+    }
+    else
+    {
+        for (int n = 0; n < numSamples; n++)
+        {
+            std::fill(&resonanceHeld[n*factor], &resonanceHeld[n*factor] + factor, resonanceSideChain[n]);
+            std::fill(&cutoffHeld[n*factor], &cutoffHeld[n*factor] + factor, cutoffSideChain[n]);
+        }
+        ladder.processBlock(fast, fast, numSamples*factor, resonanceHeld.data(), cutoffHeld.data());
+    }
+
+    oversampler.downsample(out, numSamples);
+}
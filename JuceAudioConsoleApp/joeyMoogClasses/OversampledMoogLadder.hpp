@@ -0,0 +1,95 @@
+//
+//  OversampledMoogLadder.hpp
+//
+//  Nonlinear Moog ladder run at 1x, 2x, 4x or 8x the base rate so the tanh
+//  harmonics above the base Nyquist are filtered out rather than aliased.
+//
+
+#ifndef OversampledMoogLadder_hpp
+#define OversampledMoogLadder_hpp
+
+#include <vector>
+#include "NonLinearJoeyMoogSC.hpp"
+#include "LadderOversampler.hpp"
+
+/**
+ OversampledMoogLadder class: a JoeyNonLinearMoogSC between a LadderOversampler
+ upsample and downsample. Only the ladder runs at the raised rate; whatever
+ feeds it stays at the base rate. Side chains are held for the factor samples
+ that make up each base rate sample.
+
+ The ladder limits w0 to half of its own sample rate, so at high cutoffs it
+ reaches further when oversampled.
+ */
+class OversampledMoogLadder
+{
+public:
+    //==========================================================================
+    /** Constructor */
+    OversampledMoogLadder(){};
+    /** Destructor */
+    ~OversampledMoogLadder(){};
+    //==========================================================================
+    /**
+     initialise the ladder and allocate the oversampling buffers. Not real time safe.
+
+     @param extSampRate base sample rate of environment
+     @param maxBlockSize largest block passed to processBlock()
+     @param maxFactor largest factor setOversamplingFactor() will be asked for
+     */
+    void init(double extSampRate, int maxBlockSize, int maxFactor = 8);
+
+    /**
+     switches the oversampling, clearing the resampling filters. Does not
+     allocate.
+
+     @param factor 1 (off), 2, 4 or 8, no more than the maxFactor given to init()
+     */
+    void setOversamplingFactor(int factor);
+
+    /** @returns the oversampling factor in use */
+    int getOversamplingFactor() const { return oversampler.getFactor(); }
+
+    /** @returns the delay the oversampling adds, in samples at the base rate */
+    double getLatencyInSamples() const { return oversampler.getLatencyInSamples(); }
+    //==========================================================================
+    /**
+     apply the ladder to a block of audio samples with a static side chain
+
+     @param in input audio samples
+     @param out processed audio samples (may be the same buffer as in)
+     @param numSamples number of samples in the block, no more than maxBlockSize
+     @param resonanceSideChain resonance for the whole block
+     @param cutoffSideChain cutoff for the whole block
+     */
+    void processBlock (const float* in, float* out, int numSamples,
+                       double resonanceSideChain, double cutoffSideChain);
+
+    /**
+     apply the ladder to a block of audio samples with a side chain value per sample
+
+     @param in input audio samples
+     @param out processed audio samples (may be the same buffer as in)
+     @param numSamples number of samples in the block, no more than maxBlockSize
+     @param resonanceSideChain resonance for each sample
+     @param cutoffSideChain cutoff for each sample
+     */
+    void processBlock (const float* in, float* out, int numSamples,
+                       const float* resonanceSideChain, const float* cutoffSideChain);
+
+    /** @returns the ladder, e.g. to choose its saturation tier */
+    JoeyNonLinearMoogSC& getLadder() { return ladder; }
+
+private:
+    //==========================================================================
+    /** the nonlinear ladder, running at sampleRate*factor */
+    JoeyNonLinearMoogSC ladder;
+    /** resampling filters around the ladder */
+    LadderOversampler oversampler;
+    /** base sample rate */
+    double sampleRate = 44100;
+    /** side chains repeated up to the oversampled rate */
+    std::vector<float> resonanceHeld, cutoffHeld;
+};
+
+#endif /* OversampledMoogLadder_hpp */